@@ -29,6 +29,39 @@ class SparkplugPayload(BaseModel):
     seq: int
     metrics: List[Metric]
 
+class NodeDeathPayload(BaseModel):
+    timestamp: int
+    seq: int = 0
+    metrics: Optional[List[Metric]] = None
+
+class BulkDdataMessage(BaseModel):
+    group_id: str
+    node_id: str
+    device_id: str
+    payload: SparkplugPayload
+
+class BulkDdataPayload(BaseModel):
+    messages: List[BulkDdataMessage]
+
+class RollupRow(BaseModel):
+    resolution: str
+    timestamp: int
+    group_id: str
+    node_id: str
+    device_id: str = ""
+    metric: str
+    min: float
+    max: float
+    avg: float
+    count: int
+    last: float
+
+class BulkRollupPayload(BaseModel):
+    rows: List[RollupRow]
+
+# Rollup tabeller fra paho-sub (ROLLUPS=1): én tabel per opløsning
+ROLLUP_TABLES = {"1s": "rollup_1s", "1m": "rollup_1m", "1h": "rollup_1h"}
+
 def sanitize_table_name(metric_name: str) -> str:
     """
     Konverterer metric navn til et gyldigt tabel navn
@@ -45,6 +78,14 @@ def sanitize_table_name(metric_name: str) -> str:
     
     return table_name
 
+def payload_datetime(timestamp: int) -> datetime:
+    """
+    paho-pub sender sekunder, Sparkplug B (protobuf fra paho-sub) sender millisekunder
+    """
+    if abs(timestamp) >= 100_000_000_000:
+        return datetime.fromtimestamp(timestamp / 1000)
+    return datetime.fromtimestamp(timestamp)
+
 def get_column_type(data_type: str, value: any) -> str:
     """
     Bestemmer QuestDB kolonne type baseret på dataType eller værdi
@@ -56,7 +97,17 @@ def get_column_type(data_type: str, value: any) -> str:
             "Boolean": "BOOLEAN",
             "String": "STRING",
             "Int": "INT",
-            "Double": "DOUBLE"
+            "Double": "DOUBLE",
+            # Sparkplug B datatyper fra protobuf payloads
+            "Int8": "INT",
+            "Int16": "INT",
+            "Int32": "INT",
+            "Int64": "LONG",
+            "UInt8": "INT",
+            "UInt16": "INT",
+            "UInt32": "LONG",
+            "DateTime": "LONG",
+            "Text": "STRING"
         }
         return type_mapping.get(data_type, "STRING")
     
@@ -152,7 +203,7 @@ async def ingest_nbirth(group_id: str, node_id: str, data: SparkplugPayload):
     Håndterer NBIRTH beskeder - opretter kun tabeller, indsætter IKKE data
     Topic format: spBv1.0/{group_id}/NBIRTH/{node_id}
     """
-    ts_datetime = datetime.fromtimestamp(data.timestamp)
+    ts_datetime = payload_datetime(data.timestamp)
     
     tables_created = 0
     
@@ -198,7 +249,7 @@ async def ingest_ddata(group_id: str, node_id: str, device_id: str, data: Sparkp
     Topic format: spBv1.0/{group_id}/DDATA/{node_id}/{device_id}
     """
     # Fjern timezone info for at matche QuestDB's forventninger
-    ts_datetime = datetime.fromtimestamp(data.timestamp)
+    ts_datetime = payload_datetime(data.timestamp)
     
     inserted_count = 0
     
@@ -242,6 +293,152 @@ async def ingest_ddata(group_id: str, node_id: str, device_id: str, data: Sparkp
         "timestamp": ts_datetime.isoformat()
     }
 
+@app.post("/ingest/ddata/bulk")
+async def ingest_ddata_bulk(data: BulkDdataPayload):
+    """
+    Håndterer mange DDATA beskeder i ét kald (batching fra paho-sub)
+    Rækker grupperes per tabel og indsættes med én executemany per tabel
+    """
+    rows_per_table: Dict[str, list] = {}
+    column_types: Dict[str, str] = {}
+
+    for msg in data.messages:
+        ts_datetime = payload_datetime(msg.payload.timestamp)
+        for m in msg.payload.metrics:
+            table_name = sanitize_table_name(m.name)
+            if table_name not in column_types:
+                column_types[table_name] = get_column_type(m.dataType, m.value)
+            rows_per_table.setdefault(table_name, []).append(
+                (ts_datetime, msg.node_id, msg.device_id, m.value)
+            )
+
+    inserted_count = 0
+
+    async with pool.acquire() as conn:
+        try:
+            for table_name, rows in rows_per_table.items():
+                column_type = column_types[table_name]
+                await ensure_table_exists(conn, table_name, column_type)
+
+                value_column = "status" if column_type == "STRING" else "value"
+                insert_query = f"""
+                    INSERT INTO {table_name}(timestamp, node_name, device_name, {value_column})
+                    VALUES($1, $2, $3, $4)
+                """
+                await conn.executemany(insert_query, rows)
+                inserted_count += len(rows)
+
+        except Exception as e:
+            raise HTTPException(status_code=500, detail=f"DB bulk insert failed: {e}")
+
+    return {
+        "status": "ok",
+        "messages": len(data.messages),
+        "inserted_metrics": inserted_count,
+        "tables": len(rows_per_table)
+    }
+
+async def ensure_rollup_table_exists(conn, table_name: str):
+    """
+    Opretter en rollup tabel (min/max/avg/count/last per bucket) hvis den ikke eksisterer
+    """
+    if table_name in created_tables:
+        return
+
+    partition = "MONTH" if table_name == "rollup_1h" else "DAY"
+    await conn.execute(f"""
+        CREATE TABLE IF NOT EXISTS {table_name} (
+            timestamp TIMESTAMP,
+            group_id SYMBOL,
+            node_name SYMBOL,
+            device_name SYMBOL,
+            metric SYMBOL,
+            min DOUBLE,
+            max DOUBLE,
+            avg DOUBLE,
+            count LONG,
+            last DOUBLE
+        ) timestamp(timestamp) PARTITION BY {partition};
+    """)
+    created_tables.add(table_name)
+
+@app.post("/ingest/rollup/bulk")
+async def ingest_rollup_bulk(data: BulkRollupPayload):
+    """
+    Håndterer lukkede rollup buckets fra paho-sub (1s/1m/1h)
+    Rækkerne grupperes per opløsning og indsættes med én executemany per tabel
+    """
+    rows_per_table: Dict[str, list] = {}
+
+    for r in data.rows:
+        table_name = ROLLUP_TABLES.get(r.resolution)
+        if table_name is None:
+            raise HTTPException(status_code=400, detail=f"Unknown rollup resolution '{r.resolution}'")
+        rows_per_table.setdefault(table_name, []).append((
+            datetime.fromtimestamp(r.timestamp / 1000), r.group_id, r.node_id, r.device_id,
+            r.metric, r.min, r.max, r.avg, r.count, r.last
+        ))
+
+    inserted_count = 0
+
+    async with pool.acquire() as conn:
+        try:
+            for table_name, rows in rows_per_table.items():
+                await ensure_rollup_table_exists(conn, table_name)
+                await conn.executemany(f"""
+                    INSERT INTO {table_name}(timestamp, group_id, node_name, device_name, metric,
+                                             min, max, avg, count, last)
+                    VALUES($1, $2, $3, $4, $5, $6, $7, $8, $9, $10)
+                """, rows)
+                inserted_count += len(rows)
+
+        except Exception as e:
+            raise HTTPException(status_code=500, detail=f"DB rollup insert failed: {e}")
+
+    return {
+        "status": "ok",
+        "inserted_rows": inserted_count,
+        "tables": len(rows_per_table)
+    }
+
+@app.post("/ingest/ndeath/{group_id}/{node_id}")
+async def ingest_ndeath(group_id: str, node_id: str, data: NodeDeathPayload):
+    """
+    Håndterer NDEATH beskeder - gemmer hændelsen i node_events
+    Topic format: spBv1.0/{group_id}/NDEATH/{node_id}
+    """
+    ts_datetime = payload_datetime(data.timestamp)
+
+    async with pool.acquire() as conn:
+        try:
+            if "node_events" not in created_tables:
+                await conn.execute("""
+                    CREATE TABLE IF NOT EXISTS node_events (
+                        timestamp TIMESTAMP,
+                        group_id SYMBOL,
+                        node_name SYMBOL,
+                        event SYMBOL,
+                        seq LONG
+                    ) timestamp(timestamp) PARTITION BY DAY;
+                """)
+                created_tables.add("node_events")
+
+            await conn.execute("""
+                INSERT INTO node_events(timestamp, group_id, node_name, event, seq)
+                VALUES($1, $2, $3, $4, $5)
+            """, ts_datetime, group_id, node_id, "NDEATH", data.seq)
+
+        except Exception as e:
+            raise HTTPException(status_code=500, detail=f"DB insert failed: {e}")
+
+    return {
+        "status": "ok",
+        "group_id": group_id,
+        "node_id": node_id,
+        "sequence": data.seq,
+        "timestamp": ts_datetime.isoformat()
+    }
+
 @app.get("/")
 def read_root():
     return {
@@ -386,6 +583,84 @@ async def grafana_sensor_timeseries(
             "datapoints": datapoints  
         }]  
 
+@app.get("/grafana/rollup/timeseries")
+async def grafana_rollup_timeseries(
+    metric_name: str,
+    node_id: Optional[str] = None,
+    device_id: Optional[str] = None,
+    stat: str = "avg",
+    resolution: str = "auto",
+    from_ms: Optional[int] = Query(None, alias="from"),
+    to_ms: Optional[int] = Query(None, alias="to")
+):
+    """
+    Grafana-compatible time series from the pre-aggregated rollup tables written by paho-sub.
+    stat is one of avg, min, max, last or count. With resolution=auto the range picks the
+    table: up to 2 hours reads rollup_1s, up to 7 days rollup_1m, anything longer rollup_1h,
+    so a long range dashboard reads at most a few thousand rows per series.
+    """
+    if stat not in ("avg", "min", "max", "last", "count"):
+        raise HTTPException(status_code=400, detail=f"Unknown stat '{stat}'")
+
+    if from_ms and to_ms:
+        from_time = datetime.fromtimestamp(from_ms / 1000, tz=timezone.utc)
+        to_time = datetime.fromtimestamp(to_ms / 1000, tz=timezone.utc)
+    else:
+        to_time = datetime.now(timezone.utc)
+        from_time = to_time - timedelta(hours=24)
+
+    if resolution == "auto":
+        span = to_time - from_time
+        if span <= timedelta(hours=2):
+            resolution = "1s"
+        elif span <= timedelta(days=7):
+            resolution = "1m"
+        else:
+            resolution = "1h"
+    table_name = ROLLUP_TABLES.get(resolution)
+    if table_name is None:
+        raise HTTPException(status_code=400, detail=f"Unknown rollup resolution '{resolution}'")
+
+    async with pool.acquire() as conn:
+        query = f"""
+            SELECT timestamp, {stat}
+            FROM {table_name}
+            WHERE metric = $1
+            AND timestamp >= $2
+            AND timestamp <= $3
+        """
+        params = [metric_name, from_time, to_time]
+
+        if node_id:
+            params.append(node_id)
+            query += f" AND node_name = ${len(params)}"
+        if device_id:
+            params.append(device_id)
+            query += f" AND device_name = ${len(params)}"
+
+        query += " ORDER BY timestamp"
+
+        try:
+            rows = await conn.fetch(query, *params)
+        except Exception as e:
+            raise HTTPException(status_code=500, detail=str(e))
+
+        datapoints = [
+            [float(row[stat]), int(row['timestamp'].timestamp() * 1000)]
+            for row in rows
+        ]
+
+        target_name = f"{metric_name} {stat} ({resolution})"
+        if node_id:
+            target_name += f" {node_id}"
+            if device_id:
+                target_name += f"/{device_id}"
+
+        return [{
+            "target": target_name,
+            "datapoints": datapoints
+        }]
+
 @app.get("/grafana/timeseries/node")  
 async def grafana_node_timeseries(  
     metric_name: str,  
@@ -0,0 +1,105 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+/**
+ * Backpressure from the sinks onto the MQTT receive path for QoS 1 messages.
+ *
+ * The callback takes a ticket per message and then blocks in wait_for_window() while more than
+ * max_inflight messages are still outstanding. A ticket is released when its last copy is
+ * destroyed: the sinks keep theirs until the destination accepted the batch, the spool synced
+ * it to disk or the sink gave up on it; filtered messages (duplicates, deadband, unchanged
+ * values) release theirs right away.
+ *
+ * This does not delay the PUBACK: Paho acknowledges a QoS 1 message when it is received,
+ * before message_arrived() runs. Every message in the pipeline is acked already and is lost if
+ * the process dies; the window only bounds how many there are. While it is full the broker
+ * sees no progress and keeps the rest queued in the session (and, with MQTT v5, stops at
+ * Receive Maximum). The wait is bounded by max_wait, so a stuck sink can never wedge Paho's
+ * receive thread and its keep-alives.
+ */
+class AckGate {
+public:
+    struct Counters {
+        std::atomic<uint64_t> acquired{0};
+        std::atomic<uint64_t> released{0};
+        std::atomic<uint64_t> waits{0};            // Callbacks that had to wait for the window
+        std::atomic<uint64_t> timeouts{0};         // Waits that gave up after max_wait
+        std::atomic<uint64_t> high_watermark{0};
+    };
+
+    using Ticket = std::shared_ptr<void>;
+
+    AckGate(size_t max_inflight, std::chrono::milliseconds max_wait)
+        : max_inflight(max_inflight), max_wait(max_wait) {}
+
+    AckGate(const AckGate&) = delete;
+    AckGate& operator=(const AckGate&) = delete;
+
+    // One per arrived message; keep a copy wherever the message lives on
+    Ticket acquire() {
+        size_t now;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            now = ++in_flight;
+        }
+        counters.acquired++;
+        uint64_t high = counters.high_watermark.load(std::memory_order_relaxed);
+        while (now > high && !counters.high_watermark.compare_exchange_weak(high, now)) {
+        }
+        return Ticket(this, [](AckGate* gate) { gate->release(); });
+    }
+
+    // Block until at most max_inflight tickets are outstanding, max_wait has passed or the gate is closed
+    void wait_for_window() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (in_flight <= max_inflight || closed) {
+            return;
+        }
+        counters.waits++;
+        if (!window.wait_for(lock, max_wait, [this] { return in_flight <= max_inflight || closed; })) {
+            counters.timeouts++;
+        }
+    }
+
+    // Let every waiter go, for shutdown
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        window.notify_all();
+    }
+
+    size_t outstanding() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return in_flight;
+    }
+
+    size_t window_size() const { return max_inflight; }
+    const Counters& stats() const { return counters; }
+
+private:
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --in_flight;
+        }
+        counters.released++;
+        window.notify_all();
+    }
+
+    size_t max_inflight;
+    std::chrono::milliseconds max_wait;
+    size_t in_flight = 0;
+    bool closed = false;
+    mutable std::mutex mutex;
+    std::condition_variable window;
+    Counters counters;
+};
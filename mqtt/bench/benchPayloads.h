@@ -0,0 +1,111 @@
+#pragma once
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "captureFile.h"
+#include "sparkplugTopic.h"
+
+/**
+ * Recorded payloads the benchmarks run on. By default the paho-pub messages checked in under
+ * bench/payloads (MQTT_BENCH_PAYLOAD_DIR, one file per message type). With
+ * BENCH_CAPTURE=<file> the first BENCH_CAPTURE_LIMIT (default 100000) messages of a
+ * paho-replay capture are used instead, so a recording of the real stream can be measured;
+ * message types the capture lacks fall back to the checked-in ones.
+ */
+struct RecordedMessage {
+    std::string topic;
+    std::string payload;
+};
+
+namespace bench_payloads {
+
+inline std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+inline const std::map<MessageType, RecordedMessage>& checked_in() {
+    static const std::map<MessageType, RecordedMessage> messages = [] {
+        const std::string dir = MQTT_BENCH_PAYLOAD_DIR;
+        std::map<MessageType, RecordedMessage> m;
+        auto add = [&](MessageType type, const std::string& file, const std::string& device) {
+            std::string topic = std::string("spBv1.0/UCL-SEE-A/") + message_type_name(type) + "/TLab" + device;
+            m[type] = {topic, read_file(dir + "/" + file)};
+        };
+        add(MessageType::NBIRTH, "nbirth.json", "");
+        add(MessageType::NDATA, "ndata.json", "");
+        add(MessageType::NDEATH, "ndeath.json", "");
+        add(MessageType::NCMD, "ncmd.json", "");
+        add(MessageType::DDATA, "ddata.json", "/VentSensor1");
+        add(MessageType::DCMD, "dcmd.json", "/VentSensor1");
+        return m;
+    }();
+    return messages;
+}
+
+}  // namespace bench_payloads
+
+// The whole recorded stream: a capture when BENCH_CAPTURE is set, else one message per checked-in type
+inline const std::vector<RecordedMessage>& recorded_messages() {
+    static const std::vector<RecordedMessage> messages = [] {
+        std::vector<RecordedMessage> out;
+        const char* capture = std::getenv("BENCH_CAPTURE");
+        if (capture && *capture) {
+            const char* limit_env = std::getenv("BENCH_CAPTURE_LIMIT");
+            size_t limit = limit_env ? std::strtoull(limit_env, nullptr, 10) : 100000;
+            CaptureReader reader(capture);
+            CaptureRecord record;
+            while (out.size() < limit && reader.next(record)) {
+                out.push_back({std::string(record.topic), std::string(record.payload)});
+            }
+        }
+        if (out.empty()) {
+            for (const auto& entry : bench_payloads::checked_in()) {
+                out.push_back(entry.second);
+            }
+        }
+        return out;
+    }();
+    return messages;
+}
+
+// Every recorded message of one type (at least the checked-in one)
+inline const std::vector<RecordedMessage>& recorded(MessageType type) {
+    static std::map<MessageType, std::vector<RecordedMessage>> by_type = [] {
+        std::map<MessageType, std::vector<RecordedMessage>> m;
+        for (const RecordedMessage& msg : recorded_messages()) {
+            m[parse_sparkplug_topic(msg.topic).type].push_back(msg);
+        }
+        for (const auto& entry : bench_payloads::checked_in()) {
+            if (m[entry.first].empty()) {
+                m[entry.first].push_back(entry.second);
+            }
+        }
+        return m;
+    }();
+    return by_type[type];
+}
+
+/**
+ * The checked-in DDATA grown to `count` metrics by repeating its metrics with numbered
+ * names, pretty printed like paho-pub publishes it
+ */
+inline std::string ddata_with_metrics(size_t count) {
+    nlohmann::json doc = nlohmann::json::parse(bench_payloads::checked_in().at(MessageType::DDATA).payload);
+    nlohmann::json templates = doc["metrics"];
+    doc["metrics"] = nlohmann::json::array();
+    for (size_t i = 0; i < count; ++i) {
+        nlohmann::json metric = templates[i % templates.size()];
+        if (i >= templates.size()) {
+            metric["name"] = metric["name"].get<std::string>() + "_" + std::to_string(i / templates.size());
+        }
+        doc["metrics"].push_back(metric);
+    }
+    return doc.dump(4);
+}
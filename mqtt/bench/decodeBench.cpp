@@ -0,0 +1,72 @@
+/**
+ * @file
+ * @brief Per message payload handling: the old path (to_string() copy, then one json::parse in
+ *        security analysis and another in the sink) versus one DecodedMessage shared by both.
+ */
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+#include <string>
+#include "decodedMessage.h"
+
+namespace {
+
+const std::string TOPIC = "spBv1.0/UCL-SEE-A/DDATA/TLab/VentSensor1";
+
+// DDATA as published by paho-pub (pretty printed with dump(4))
+const std::string DDATA_PAYLOAD = R"({
+    "metrics": [
+        {
+            "dataType": "Float",
+            "name": "Inputs/Indoor_temperature",
+            "timestamp": 1731600000,
+            "value": 26.2
+        },
+        {
+            "dataType": "Float",
+            "name": "Inputs/Outdoor_temperature",
+            "timestamp": 1731600000,
+            "value": 15.2
+        }
+    ],
+    "seq": 2,
+    "timestamp": 1731600000
+})";
+
+void BM_Payload_ParsePerConsumer(benchmark::State& state) {
+    for (auto _ : state) {
+        std::string payload = DDATA_PAYLOAD;
+        double sum = 0;
+        // Security analysis
+        nlohmann::json analysis = nlohmann::json::parse(payload);
+        for (const auto& m : analysis["metrics"]) {
+            sum += m["value"].get<double>();
+        }
+        // Sink
+        nlohmann::json sink = nlohmann::json::parse(payload);
+        for (const auto& m : sink["metrics"]) {
+            sum += m["value"].get<double>();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Payload_ParsePerConsumer);
+
+void BM_Payload_DecodeOnce(benchmark::State& state) {
+    auto owner = std::make_shared<std::string>(DDATA_PAYLOAD);
+    SparkplugTopic topic = parse_sparkplug_topic(TOPIC);
+    for (auto _ : state) {
+        DecodedMessage::Ptr msg = DecodedMessage::decode(owner, topic, *owner, std::chrono::steady_clock::now());
+        double sum = 0;
+        for (int consumer = 0; consumer < 2; ++consumer) {
+            for (const DecodedMetric& m : msg->metrics) {
+                sum += m.as_double();
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Payload_DecodeOnce);
+
+}  // namespace
@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @brief Throughput of FastAPI POSTs: one CURL handle per message (old send_to_fastapi)
+ *        versus the keep-alive CurlPool. Runs against a local stand-in HTTP server,
+ *        items_per_second is the achieved msg/s.
+ */
+#include <benchmark/benchmark.h>
+#include <curl/curl.h>
+#include <memory>
+#include <string>
+#include "curlPool.h"
+#include "localHttpServer.h"
+
+namespace {
+
+// DDATA as published by paho-pub (pretty printed with dump(4))
+const std::string DDATA_PAYLOAD = R"({
+    "metrics": [
+        {
+            "dataType": "Float",
+            "name": "Inputs/Indoor_temperature",
+            "timestamp": 1731600000,
+            "value": 26.2
+        },
+        {
+            "dataType": "Float",
+            "name": "Inputs/Outdoor_temperature",
+            "timestamp": 1731600000,
+            "value": 15.2
+        }
+    ],
+    "seq": 2,
+    "timestamp": 1731600000
+})";
+
+const std::string DDATA_ENDPOINT = "/ingest/ddata/UCL-SEE-A/TLab/VentSensor1";
+
+LocalHttpServer& server() {
+    static LocalHttpServer instance;
+    return instance;
+}
+
+size_t discard_response(void*, size_t size, size_t nmemb, void*) {
+    return size * nmemb;
+}
+
+// The pre-pool implementation: init, build headers, POST, tear down, per message
+bool post_fresh_handle(const std::string& url, const std::string& payload) {
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        return false;
+    }
+    struct curl_slist* headers = NULL;
+    headers = curl_slist_append(headers, "Content-Type: application/json");
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, payload.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, discard_response);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 5L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    CURLcode res = curl_easy_perform(curl);
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+    return res == CURLE_OK;
+}
+
+}  // namespace
+
+static void BM_FastApiPost_FreshHandle(benchmark::State& state) {
+    const std::string url = server().url() + DDATA_ENDPOINT;
+    size_t failures = 0;
+    for (auto _ : state) {
+        if (!post_fresh_handle(url, DDATA_PAYLOAD)) {
+            failures++;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["failures"] = (double)failures;
+}
+BENCHMARK(BM_FastApiPost_FreshHandle)->Threads(1)->Threads(4)->UseRealTime();
+
+static void BM_FastApiPost_Pooled(benchmark::State& state) {
+    // One pool shared by all benchmark threads, sized like FASTAPI_POOL_SIZE=4
+    static CurlPool pool(server().url(), 4, 5000);
+    size_t failures = 0;
+    for (auto _ : state) {
+        CurlPool::Response res = pool.post(DDATA_ENDPOINT, DDATA_PAYLOAD);
+        if (res.code != CURLE_OK || res.http_code != 200) {
+            failures++;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["failures"] = (double)failures;
+}
+BENCHMARK(BM_FastApiPost_Pooled)->Threads(1)->Threads(4)->UseRealTime();
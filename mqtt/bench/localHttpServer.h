@@ -0,0 +1,141 @@
+#pragma once
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <strings.h>
+#include <chrono>
+#include <thread>
+#include <unordered_set>
+
+/**
+ * Minimal HTTP/1.1 stand-in for FastAPI used by the benchmarks.
+ * Listens on 127.0.0.1 (random port), answers every request with 200 and
+ * {"status":"ok"}, and keeps connections open unless the client asks to close.
+ */
+class LocalHttpServer {
+public:
+    LocalHttpServer() {
+        listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        ::bind(listen_fd, (sockaddr*)&addr, sizeof(addr));
+        ::listen(listen_fd, 128);
+
+        socklen_t len = sizeof(addr);
+        ::getsockname(listen_fd, (sockaddr*)&addr, &len);
+        port = ntohs(addr.sin_port);
+
+        acceptor = std::thread([this] { accept_loop(); });
+    }
+
+    ~LocalHttpServer() {
+        running = false;
+        ::shutdown(listen_fd, SHUT_RDWR);
+        ::close(listen_fd);
+        acceptor.join();
+        {
+            std::lock_guard<std::mutex> lock(conn_mutex);
+            for (int fd : conn_fds) {
+                ::shutdown(fd, SHUT_RDWR);
+            }
+        }
+        while (active_connections.load() > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    std::string url() const { return "http://127.0.0.1:" + std::to_string(port); }
+    size_t requests() const { return request_count.load(); }
+    size_t connections() const { return connection_count.load(); }
+
+private:
+    void accept_loop() {
+        while (running) {
+            int fd = ::accept(listen_fd, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            connection_count++;
+            active_connections++;
+            {
+                std::lock_guard<std::mutex> lock(conn_mutex);
+                conn_fds.insert(fd);
+            }
+            std::thread([this, fd] {
+                serve(fd);
+                {
+                    std::lock_guard<std::mutex> lock(conn_mutex);
+                    conn_fds.erase(fd);
+                    ::close(fd);
+                }
+                active_connections--;
+            }).detach();
+        }
+    }
+
+    void serve(int fd) {
+        static const std::string reply =
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: application/json\r\n"
+            "Content-Length: 15\r\n"
+            "\r\n"
+            "{\"status\":\"ok\"}";
+
+        std::string buf;
+        char chunk[16384];
+        while (true) {
+            size_t header_end = buf.find("\r\n\r\n");
+            while (header_end == std::string::npos) {
+                ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) {
+                    return;
+                }
+                buf.append(chunk, n);
+                header_end = buf.find("\r\n\r\n");
+            }
+
+            size_t body_len = 0;
+            const char* cl = strcasestr(buf.c_str(), "content-length:");
+            if (cl && cl < buf.c_str() + header_end) {
+                body_len = std::strtoul(cl + 15, nullptr, 10);
+            }
+            bool close_after = strcasestr(buf.substr(0, header_end).c_str(), "connection: close") != nullptr;
+
+            size_t total = header_end + 4 + body_len;
+            while (buf.size() < total) {
+                ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) {
+                    return;
+                }
+                buf.append(chunk, n);
+            }
+            buf.erase(0, total);
+            request_count++;
+
+            if (::send(fd, reply.data(), reply.size(), MSG_NOSIGNAL) < 0 || close_after) {
+                return;
+            }
+        }
+    }
+
+    int listen_fd = -1;
+    uint16_t port = 0;
+    std::atomic<bool> running{true};
+    std::atomic<size_t> request_count{0};
+    std::atomic<size_t> connection_count{0};
+    std::atomic<size_t> active_connections{0};
+    std::thread acceptor;
+    std::mutex conn_mutex;
+    std::unordered_set<int> conn_fds;
+};
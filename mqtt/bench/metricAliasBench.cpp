@@ -0,0 +1,99 @@
+/**
+ * @file
+ * @brief Per metric lookup of node state: the "group/node/device|metric" string key every
+ *        stage used to build and hash, versus MetricAliasTable resolving each metric once to
+ *        a slot, through its alias (flat vector) or its name (one hash), at 10 to 1000 metrics.
+ */
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "decodedMessage.h"
+#include "metricAliasTable.h"
+
+namespace {
+
+const std::string DDATA_TOPIC = "spBv1.0/UCL-SEE-A/DDATA/TLab/VentSensor1";
+const std::string DBIRTH_TOPIC = "spBv1.0/UCL-SEE-A/DBIRTH/TLab/VentSensor1";
+
+std::vector<std::string> metric_names(size_t count) {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < count; ++i) {
+        names.push_back("Inputs/Metric_" + std::to_string(i));
+    }
+    return names;
+}
+
+// DBIRTH binding every name to alias i + 1
+std::string dbirth_payload(const std::vector<std::string>& names) {
+    nlohmann::json doc;
+    doc["timestamp"] = 1731600000000;
+    doc["seq"] = 0;
+    doc["metrics"] = nlohmann::json::array();
+    for (size_t i = 0; i < names.size(); ++i) {
+        doc["metrics"].push_back({{"name", names[i]}, {"alias", i + 1}, {"timestamp", 1731600000000},
+                                  {"dataType", "Float"}, {"value", 20.0}});
+    }
+    return doc.dump();
+}
+
+std::vector<DecodedMetric> ddata_metrics(const std::vector<std::string>& names, bool alias_only) {
+    std::vector<DecodedMetric> metrics(names.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (alias_only) {
+            metrics[i].alias = i + 1;
+            metrics[i].has_alias = true;
+        } else {
+            metrics[i].name = names[i];
+        }
+        metrics[i].value = 21.5;
+    }
+    return metrics;
+}
+
+// What the deadband filter, rollups and load controller each did per metric before the slots
+void BM_MetricState_StringKey(benchmark::State& state) {
+    const std::vector<std::string> names = metric_names((size_t)state.range(0));
+    const SparkplugTopic topic = parse_sparkplug_topic(DDATA_TOPIC);
+    std::unordered_map<std::string, double> values;
+    std::string key;
+    for (auto _ : state) {
+        for (const std::string& name : names) {
+            key.assign(topic.group_id);
+            key += '/';
+            key.append(topic.node_id);
+            key += '/';
+            key.append(topic.device_id);
+            key += '|';
+            key += name;
+            values[key] += 1;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MetricState_StringKey)->Arg(10)->Arg(100)->Arg(1000);
+
+void BM_AliasTable_Resolve(benchmark::State& state, bool alias_only) {
+    const std::vector<std::string> names = metric_names((size_t)state.range(0));
+    MetricAliasTable table;
+    auto birth_bytes = std::make_shared<std::string>(dbirth_payload(names));
+    DecodedMessage::Ptr birth = DecodedMessage::decode(birth_bytes, parse_sparkplug_topic(DBIRTH_TOPIC), *birth_bytes,
+                                                       std::chrono::steady_clock::now(), &table);
+
+    const SparkplugTopic topic = parse_sparkplug_topic(DDATA_TOPIC);
+    std::vector<DecodedMetric> metrics = ddata_metrics(names, alias_only);
+    bool named = false;
+    for (auto _ : state) {
+        std::shared_ptr<const void> keep = table.resolve(topic, metrics, named);
+        benchmark::DoNotOptimize(keep);
+    }
+    if (!metrics.front().has_index()) {
+        state.SkipWithError("metric not resolved");
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_CAPTURE(BM_AliasTable_Resolve, alias, true)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK_CAPTURE(BM_AliasTable_Resolve, name, false)->Arg(10)->Arg(100)->Arg(1000);
+
+}  // namespace
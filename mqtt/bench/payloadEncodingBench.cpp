@@ -0,0 +1,56 @@
+/**
+ * @file
+ * @brief Bytes per message and DecodedMessage::decode() time of the recorded DDATA, grown to
+ *        10 and 100 metrics, in every wire encoding: pretty and compact JSON, CBOR, MessagePack
+ *        and Sparkplug B protobuf. The bytes_per_msg counter is the payload size.
+ */
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include "benchPayloads.h"
+#include "decodedMessage.h"
+#include "payloadEncoding.h"
+#include "sparkplugProto.h"
+
+namespace {
+
+const std::string TOPIC = "spBv1.0/UCL-SEE-A/DDATA/TLab/VentSensor1";
+
+enum class Wire { PrettyJson, Json, Cbor, MessagePack, Protobuf };
+
+std::string encoded_ddata(Wire wire, size_t metrics) {
+    std::string pretty = ddata_with_metrics(metrics);
+    switch (wire) {
+    case Wire::Json: return encode_payload(nlohmann::json::parse(pretty), PayloadEncoding::Json);
+    case Wire::Cbor: return encode_payload(nlohmann::json::parse(pretty), PayloadEncoding::Cbor);
+    case Wire::MessagePack: return encode_payload(nlohmann::json::parse(pretty), PayloadEncoding::MessagePack);
+    case Wire::Protobuf: {
+        DecodedMessage::Ptr msg = DecodedMessage::decode(TOPIC, pretty);
+        return encode_sparkplug_protobuf(msg->timestamp_ms, msg->seq, msg->metrics);
+    }
+    default: return pretty;
+    }
+}
+
+void BM_Encoding_Decode(benchmark::State& state, Wire wire) {
+    auto owner = std::make_shared<std::string>(encoded_ddata(wire, (size_t)state.range(0)));
+    SparkplugTopic topic = parse_sparkplug_topic(TOPIC);
+    for (auto _ : state) {
+        DecodedMessage::Ptr msg = DecodedMessage::decode(owner, topic, *owner, std::chrono::steady_clock::now());
+        if (!msg->ok) {
+            state.SkipWithError(msg->error.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(msg);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * (int64_t)owner->size());
+    state.counters["bytes_per_msg"] = (double)owner->size();
+}
+BENCHMARK_CAPTURE(BM_Encoding_Decode, pretty_json, Wire::PrettyJson)->Arg(10)->Arg(100);
+BENCHMARK_CAPTURE(BM_Encoding_Decode, json, Wire::Json)->Arg(10)->Arg(100);
+BENCHMARK_CAPTURE(BM_Encoding_Decode, cbor, Wire::Cbor)->Arg(10)->Arg(100);
+BENCHMARK_CAPTURE(BM_Encoding_Decode, msgpack, Wire::MessagePack)->Arg(10)->Arg(100);
+BENCHMARK_CAPTURE(BM_Encoding_Decode, protobuf, Wire::Protobuf)->Arg(10)->Arg(100);
+
+}  // namespace
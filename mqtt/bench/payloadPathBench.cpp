@@ -0,0 +1,101 @@
+/**
+ * @file
+ * @brief The per payload work between arrival and the FastAPI POST, on recorded payloads:
+ *        JSON decoding at 1 to 1000 metrics (against a plain nlohmann DOM parse), metric
+ *        values as strings for the log lines, and the /ingest/ddata/bulk request body.
+ */
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+#include "benchPayloads.h"
+#include "decodedMessage.h"
+#include "fastapiSink.h"
+
+namespace {
+
+const std::string TOPIC = "spBv1.0/UCL-SEE-A/DDATA/TLab/VentSensor1";
+
+void BM_JsonPayload_DomParse(benchmark::State& state) {
+    const std::string payload = ddata_with_metrics((size_t)state.range(0));
+    for (auto _ : state) {
+        nlohmann::json doc = nlohmann::json::parse(payload);
+        benchmark::DoNotOptimize(doc);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * (int64_t)payload.size());
+}
+BENCHMARK(BM_JsonPayload_DomParse)->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+
+void BM_JsonPayload_Decode(benchmark::State& state) {
+    auto owner = std::make_shared<std::string>(ddata_with_metrics((size_t)state.range(0)));
+    SparkplugTopic topic = parse_sparkplug_topic(TOPIC);
+    for (auto _ : state) {
+        DecodedMessage::Ptr msg = DecodedMessage::decode(owner, topic, *owner, std::chrono::steady_clock::now());
+        benchmark::DoNotOptimize(msg);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * (int64_t)owner->size());
+}
+BENCHMARK(BM_JsonPayload_Decode)->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+
+// Every recorded message in turn (a whole capture with BENCH_CAPTURE)
+void BM_RecordedStream_Decode(benchmark::State& state) {
+    const std::vector<RecordedMessage>& messages = recorded_messages();
+    size_t i = 0;
+    int64_t bytes = 0;
+    for (auto _ : state) {
+        const RecordedMessage& m = messages[i++ % messages.size()];
+        DecodedMessage::Ptr msg = DecodedMessage::decode(m.topic, m.payload);
+        benchmark::DoNotOptimize(msg);
+        bytes += (int64_t)m.payload.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_RecordedStream_Decode);
+
+// What get_metric_value_as_string() did, now DecodedMetric::value_string(), over every recorded metric
+void BM_MetricValueString(benchmark::State& state) {
+    std::vector<DecodedMessage::Ptr> decoded;
+    std::vector<const DecodedMetric*> metrics;
+    for (const RecordedMessage& m : recorded_messages()) {
+        decoded.push_back(DecodedMessage::decode(m.topic, m.payload));
+        for (const DecodedMetric& metric : decoded.back()->metrics) {
+            metrics.push_back(&metric);
+        }
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        std::string value = metrics[i++ % metrics.size()]->value_string();
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MetricValueString);
+
+// Request body of one bulk POST of N recorded DDATA messages
+void BM_FastApiBulkBody(benchmark::State& state) {
+    std::vector<DecodedMessage::Ptr> decoded;
+    const std::vector<RecordedMessage>& ddata = recorded(MessageType::DDATA);
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        const RecordedMessage& m = ddata[(size_t)i % ddata.size()];
+        decoded.push_back(DecodedMessage::decode(m.topic, m.payload));
+    }
+    std::vector<const DecodedMessage*> batch;
+    for (const DecodedMessage::Ptr& msg : decoded) {
+        batch.push_back(msg.get());
+    }
+    int64_t bytes = 0;
+    for (auto _ : state) {
+        std::string body = FastApiSink::build_bulk_body(batch);
+        bytes += (int64_t)body.size();
+        benchmark::DoNotOptimize(body);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_FastApiBulkBody)->Arg(1)->Arg(10)->Arg(100)->Arg(500);
+
+}  // namespace
@@ -0,0 +1,57 @@
+/**
+ * @file
+ * @brief MQTTSecurityLogger::analyze_* per Sparkplug message type, on pre-decoded recorded
+ *        payloads. The loggers are async (as in paho-sub) into a null sink at level info, so
+ *        this measures the analysis plus formatting and enqueueing its log lines.
+ */
+#include <benchmark/benchmark.h>
+#include <spdlog/sinks/null_sink.h>
+#include <vector>
+#include "benchPayloads.h"
+#include "decodedMessage.h"
+#include "spdlogSecurity.h"
+
+namespace {
+
+using Analyze = void (MQTTSecurityLogger::*)(const DecodedMessage&);
+
+MQTTSecurityLogger& security_logger() {
+    static MQTTSecurityLogger* logger = [] {
+        spdlog::init_thread_pool(8192, 1);
+        spdlog::set_level(spdlog::level::info);
+        auto* l = new MQTTSecurityLogger();
+        l->setup_loggers(std::make_shared<spdlog::sinks::null_sink_mt>());
+        return l;
+    }();
+    return *logger;
+}
+
+std::vector<DecodedMessage::Ptr> decode_recorded(MessageType type) {
+    std::vector<DecodedMessage::Ptr> decoded;
+    for (const RecordedMessage& msg : recorded(type)) {
+        decoded.push_back(DecodedMessage::decode(msg.topic, msg.payload));
+    }
+    return decoded;
+}
+
+void BM_Analyze(benchmark::State& state, MessageType type, Analyze analyze) {
+    MQTTSecurityLogger& logger = security_logger();
+    // DDATA/NDATA checks look for a registered node, as in a running subscriber
+    for (const DecodedMessage::Ptr& birth : decode_recorded(MessageType::NBIRTH)) {
+        logger.analyze_nbirth_message(*birth);
+    }
+    std::vector<DecodedMessage::Ptr> messages = decode_recorded(type);
+    size_t i = 0;
+    for (auto _ : state) {
+        (logger.*analyze)(*messages[i++ % messages.size()]);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_Analyze, NBIRTH, MessageType::NBIRTH, &MQTTSecurityLogger::analyze_nbirth_message);
+BENCHMARK_CAPTURE(BM_Analyze, NDATA, MessageType::NDATA, &MQTTSecurityLogger::analyze_ndata_message);
+BENCHMARK_CAPTURE(BM_Analyze, DDATA, MessageType::DDATA, &MQTTSecurityLogger::analyze_ddata_message);
+BENCHMARK_CAPTURE(BM_Analyze, NDEATH, MessageType::NDEATH, &MQTTSecurityLogger::analyze_ndeath_message);
+BENCHMARK_CAPTURE(BM_Analyze, NCMD, MessageType::NCMD, &MQTTSecurityLogger::analyze_ncmd_message);
+BENCHMARK_CAPTURE(BM_Analyze, DCMD, MessageType::DCMD, &MQTTSecurityLogger::analyze_dcmd_message);
+
+}  // namespace
@@ -0,0 +1,65 @@
+/**
+ * @file
+ * @brief DecodedMessage::decode() of the same DDATA as pretty printed JSON (paho-pub) and as
+ *        Sparkplug B protobuf. bytes_per_second is the payload size times msg/s.
+ */
+#include <benchmark/benchmark.h>
+#include <string>
+#include "decodedMessage.h"
+#include "sparkplugProto.h"
+
+namespace {
+
+const std::string TOPIC = "spBv1.0/UCL-SEE-A/DDATA/TLab/VentSensor1";
+
+// DDATA as published by paho-pub (pretty printed with dump(4))
+const std::string DDATA_JSON = R"({
+    "metrics": [
+        {
+            "dataType": "Float",
+            "name": "Inputs/Indoor_temperature",
+            "timestamp": 1731600000,
+            "value": 26.2
+        },
+        {
+            "dataType": "Float",
+            "name": "Inputs/Outdoor_temperature",
+            "timestamp": 1731600000,
+            "value": 15.2
+        }
+    ],
+    "seq": 2,
+    "timestamp": 1731600000
+})";
+
+const std::string& ddata_protobuf() {
+    static const std::string bytes = [] {
+        DecodedMessage::Ptr json_msg = DecodedMessage::decode(TOPIC, DDATA_JSON);
+        return encode_sparkplug_protobuf(json_msg->timestamp_ms, json_msg->seq, json_msg->metrics);
+    }();
+    return bytes;
+}
+
+void run_decode(benchmark::State& state, const std::string& payload) {
+    auto owner = std::make_shared<std::string>(payload);
+    SparkplugTopic topic = parse_sparkplug_topic(TOPIC);
+    for (auto _ : state) {
+        DecodedMessage::Ptr msg = DecodedMessage::decode(owner, topic, *owner, std::chrono::steady_clock::now());
+        benchmark::DoNotOptimize(msg->metrics.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * (int64_t)payload.size());
+    state.counters["payload_bytes"] = (double)payload.size();
+}
+
+void BM_Decode_Json(benchmark::State& state) {
+    run_decode(state, DDATA_JSON);
+}
+BENCHMARK(BM_Decode_Json);
+
+void BM_Decode_Protobuf(benchmark::State& state) {
+    run_decode(state, ddata_protobuf());
+}
+BENCHMARK(BM_Decode_Protobuf);
+
+}  // namespace
@@ -0,0 +1,74 @@
+/**
+ * @file
+ * @brief Sparkplug topic parsing: the old stringstream/vector/tuple parse_topic plus
+ *        find("/XXXX/") dispatch versus the single pass parse_sparkplug_topic().
+ */
+#include <benchmark/benchmark.h>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "sparkplugTopic.h"
+
+namespace {
+
+const std::vector<std::string> TOPICS = {
+    "spBv1.0/UCL-SEE-A/DDATA/TLab/VentSensor1",
+    "spBv1.0/UCL-SEE-A/NDATA/TLab",
+    "spBv1.0/UCL-SEE-A/NBIRTH/TLab",
+    "spBv1.0/UCL-SEE-A/DCMD/TLab/VentSensor1",
+};
+
+// parse_topic() as it was in paho-sub.cpp
+std::tuple<std::string, std::string, std::string, std::string> legacy_parse_topic(const std::string& topic) {
+    std::vector<std::string> parts;
+    std::stringstream ss(topic);
+    std::string item;
+
+    while (std::getline(ss, item, '/')) {
+        parts.push_back(item);
+    }
+
+    if (parts.size() >= 4) {
+        std::string device_id = parts.size() > 4 ? parts[4] : "";
+        return {parts[1], parts[2], parts[3], device_id};
+    }
+    return {"", "", "", ""};
+}
+
+// message_arrived's if/else chain of topic.find() calls
+int legacy_dispatch(const std::string& topic) {
+    if (topic.find("/NBIRTH/") != std::string::npos) return 0;
+    if (topic.find("/DDATA/") != std::string::npos) return 1;
+    if (topic.find("/NDATA/") != std::string::npos) return 2;
+    if (topic.find("/NDEATH/") != std::string::npos) return 3;
+    if (topic.find("/NCMD/") != std::string::npos) return 4;
+    if (topic.find("/DCMD/") != std::string::npos) return 5;
+    return -1;
+}
+
+void BM_TopicParse_Legacy(benchmark::State& state) {
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& topic = TOPICS[i++ % TOPICS.size()];
+        auto parsed = legacy_parse_topic(topic);
+        int type = legacy_dispatch(topic);
+        benchmark::DoNotOptimize(parsed);
+        benchmark::DoNotOptimize(type);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TopicParse_Legacy);
+
+void BM_TopicParse_SinglePass(benchmark::State& state) {
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& topic = TOPICS[i++ % TOPICS.size()];
+        SparkplugTopic parsed = parse_sparkplug_topic(topic);
+        benchmark::DoNotOptimize(parsed);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TopicParse_SinglePass);
+
+}  // namespace
@@ -0,0 +1,92 @@
+/**
+ * @file
+ * @brief Routing a topic to its subscription: trying every filter in turn versus the
+ *        TopicRouter trie, for a growing number of sites (each site adds six filters).
+ */
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "topicRouter.h"
+
+namespace {
+
+std::vector<std::string> site_filters(size_t sites) {
+    std::vector<std::string> filters;
+    for (size_t i = 0; i < sites; ++i) {
+        std::string group = "Site-" + std::to_string(i);
+        filters.push_back("spBv1.0/" + group + "/NBIRTH/+");
+        filters.push_back("spBv1.0/" + group + "/NDEATH/+");
+        filters.push_back("spBv1.0/" + group + "/DDATA/+/+");
+        filters.push_back("spBv1.0/" + group + "/NDATA/+");
+        filters.push_back("spBv1.0/" + group + "/NCMD/+");
+        filters.push_back("spBv1.0/" + group + "/DCMD/#");
+    }
+    return filters;
+}
+
+std::vector<std::string> site_topics(size_t sites) {
+    std::vector<std::string> topics;
+    for (size_t i = 0; i < sites; i += std::max<size_t>(1, sites / 8)) {
+        std::string group = "Site-" + std::to_string(i);
+        topics.push_back("spBv1.0/" + group + "/DDATA/TLab/VentSensor1");
+        topics.push_back("spBv1.0/" + group + "/NDATA/TLab");
+    }
+    return topics;
+}
+
+// Plain MQTT filter match, level by level
+bool filter_matches(std::string_view filter, std::string_view topic) {
+    size_t f = 0, t = 0;
+    for (;;) {
+        size_t fs = filter.find('/', f);
+        size_t ts = topic.find('/', t);
+        std::string_view fl = filter.substr(f, fs == std::string_view::npos ? std::string_view::npos : fs - f);
+        std::string_view tl = topic.substr(t, ts == std::string_view::npos ? std::string_view::npos : ts - t);
+        if (fl == "#") return true;
+        if (fl != "+" && fl != tl) return false;
+        if (fs == std::string_view::npos || ts == std::string_view::npos) {
+            return fs == ts || (ts == std::string_view::npos && filter.substr(fs + 1) == "#");
+        }
+        f = fs + 1;
+        t = ts + 1;
+    }
+}
+
+void BM_Route_Linear(benchmark::State& state) {
+    auto filters = site_filters((size_t)state.range(0));
+    auto topics = site_topics((size_t)state.range(0));
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& topic = topics[i++ % topics.size()];
+        size_t found = filters.size();
+        for (size_t f = 0; f < filters.size(); ++f) {
+            if (filter_matches(filters[f], topic)) {
+                found = f;
+                break;
+            }
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Route_Linear)->Arg(1)->Arg(16)->Arg(256);
+
+void BM_Route_Trie(benchmark::State& state) {
+    auto filters = site_filters((size_t)state.range(0));
+    auto topics = site_topics((size_t)state.range(0));
+    TopicRouter<size_t> router;
+    for (size_t f = 0; f < filters.size(); ++f) {
+        router.add(filters[f], f);
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        const size_t* found = router.match(topics[i++ % topics.size()]);
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Route_Trie)->Arg(1)->Arg(16)->Arg(256);
+
+}  // namespace
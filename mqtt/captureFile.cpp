@@ -0,0 +1,180 @@
+#include "captureFile.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+const char MAGIC[8] = {'M', 'Q', 'C', 'A', 'P', 0, 0, 1};
+const size_t FLUSH_BYTES = 1024 * 1024;
+const uint64_t MAX_FIELD_BYTES = 268435455;    // MQTT's own limit for a packet
+
+void put_u64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out += (char)(value >> (8 * i));
+    }
+}
+
+}  // namespace
+
+CaptureWriter::CaptureWriter(const std::string& path) {
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return;
+    }
+    buffer.reserve(FLUSH_BYTES + 64 * 1024);
+    buffer.append(MAGIC, sizeof(MAGIC));
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    put_u64(buffer, (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+}
+
+CaptureWriter::~CaptureWriter() {
+    if (file) {
+        flush();
+        std::fclose(file);
+    }
+}
+
+void CaptureWriter::put_varint(uint64_t value) {
+    while (value >= 0x80) {
+        buffer += (char)(value | 0x80);
+        value >>= 7;
+    }
+    buffer += (char)value;
+}
+
+bool CaptureWriter::append(uint64_t offset_us, std::string_view topic, std::string_view payload, int qos,
+                           bool retained) {
+    if (!file) {
+        return false;
+    }
+    put_varint(offset_us > last_offset_us ? offset_us - last_offset_us : 0);
+    last_offset_us = std::max(last_offset_us, offset_us);
+    buffer += (char)((qos & 3) | (retained ? 4 : 0));
+
+    auto it = topic_refs.find(std::string(topic));
+    if (it != topic_refs.end()) {
+        put_varint(it->second);
+    } else {
+        uint32_t ref = (uint32_t)topic_refs.size();
+        topic_refs.emplace(std::string(topic), ref);
+        put_varint(ref);
+        put_varint(topic.size());
+        buffer.append(topic);
+    }
+    put_varint(payload.size());
+    buffer.append(payload);
+    ++count;
+
+    return buffer.size() < FLUSH_BYTES || flush();
+}
+
+bool CaptureWriter::flush() {
+    if (!file) {
+        return false;
+    }
+    bool ok = buffer.empty() || std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    written += buffer.size();
+    buffer.clear();
+    return std::fflush(file) == 0 && ok;
+}
+
+CaptureReader::CaptureReader(const std::string& path) {
+    file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        failure = std::strerror(errno);
+        return;
+    }
+    if (!rewind()) {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+CaptureReader::~CaptureReader() {
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+bool CaptureReader::rewind() {
+    unsigned char header[16];
+    if (std::fseek(file, 0, SEEK_SET) != 0 || std::fread(header, 1, sizeof(header), file) != sizeof(header) ||
+        std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0) {
+        failure = "not a capture file";
+        return false;
+    }
+    start_us = 0;
+    for (int i = 7; i >= 0; --i) {
+        start_us = (start_us << 8) | header[8 + i];
+    }
+    offset_us = 0;
+    topics_seen = 0;
+    return true;
+}
+
+bool CaptureReader::get_varint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = std::fgetc(file);
+        if (c == EOF) {
+            return false;
+        }
+        value |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CaptureReader::get_bytes(std::string& out, uint64_t length) {
+    if (length > MAX_FIELD_BYTES) {
+        return false;
+    }
+    out.resize(length);
+    return length == 0 || std::fread(&out[0], 1, length, file) == length;
+}
+
+bool CaptureReader::next(CaptureRecord& record) {
+    if (!file) {
+        return false;
+    }
+    uint64_t delta;
+    if (!get_varint(delta)) {
+        return false;    // Clean end of file
+    }
+    failure = "truncated record";
+    int flags = std::fgetc(file);
+    uint64_t ref;
+    if (flags == EOF || !get_varint(ref) || ref > topics_seen) {
+        return false;
+    }
+    if (ref == topics_seen) {
+        uint64_t length;
+        std::string topic;
+        if (!get_varint(length) || !get_bytes(topic, length)) {
+            return false;
+        }
+        // After a rewind the table already holds it
+        if (ref == topic_table.size()) {
+            topic_table.push_back(std::move(topic));
+        }
+        ++topics_seen;
+    }
+    uint64_t length;
+    if (!get_varint(length) || !get_bytes(payload, length)) {
+        return false;
+    }
+    failure.clear();
+
+    offset_us += delta;
+    record.offset_us = offset_us;
+    record.topic_index = (uint32_t)ref;
+    record.topic = topic_table[ref];
+    record.payload = payload;
+    record.qos = flags & 3;
+    record.retained = (flags & 4) != 0;
+    return true;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * One captured MQTT message. Views point into the CaptureReader's buffers and stay valid
+ * until the next call to next().
+ */
+struct CaptureRecord {
+    uint64_t offset_us = 0;        // Arrival time since the start of the capture
+    uint32_t topic_index = 0;      // Index into CaptureReader::topics()
+    std::string_view topic;
+    std::string_view payload;
+    int qos = 0;
+    bool retained = false;
+};
+
+/**
+ * Compact binary capture of an MQTT stream, written by paho-replay record.
+ *
+ * File layout: the magic "MQCAP\0\0\1", the wall clock start in microseconds since epoch
+ * (u64, little endian), then one record per message:
+ *   [varint arrival delta us][u8 flags: qos | retained << 2][varint topic ref]
+ *   ([varint length][topic bytes] when the ref is new)[varint length][payload bytes]
+ * Topics are interned: a ref equal to the number of topics seen so far introduces a new one,
+ * anything lower repeats an earlier topic. Timestamps are deltas to the previous record.
+ * A Sparkplug stream of a few hundred topics costs a handful of bytes per message on top of
+ * the payload.
+ */
+class CaptureWriter {
+public:
+    explicit CaptureWriter(const std::string& path);
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    bool usable() const { return file != nullptr; }
+
+    // offset_us must not go backwards
+    bool append(uint64_t offset_us, std::string_view topic, std::string_view payload, int qos, bool retained);
+
+    bool flush();
+
+    uint64_t records() const { return count; }
+    uint64_t bytes() const { return written; }
+    size_t topics() const { return topic_refs.size(); }
+
+private:
+    void put_varint(uint64_t value);
+
+    std::FILE* file = nullptr;
+    std::string buffer;
+    std::unordered_map<std::string, uint32_t> topic_refs;
+    uint64_t last_offset_us = 0;
+    uint64_t count = 0;
+    uint64_t written = 0;
+};
+
+/**
+ * Reads a capture back in order, see CaptureWriter for the format
+ */
+class CaptureReader {
+public:
+    explicit CaptureReader(const std::string& path);
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    bool usable() const { return file != nullptr; }
+
+    // False at the end of the file; error() tells a truncated or corrupt file apart
+    bool next(CaptureRecord& record);
+
+    // Back to the first record (the topic table is kept)
+    bool rewind();
+
+    const std::string& error() const { return failure; }
+    uint64_t start_epoch_us() const { return start_us; }
+
+    // Every topic read so far, by topic_index
+    const std::vector<std::string>& topics() const { return topic_table; }
+
+private:
+    bool get_varint(uint64_t& value);
+    bool get_bytes(std::string& out, uint64_t length);
+
+    std::FILE* file = nullptr;
+    std::string failure;
+    uint64_t start_us = 0;
+    uint64_t offset_us = 0;
+    uint32_t topics_seen = 0;           // Since the last rewind
+    std::vector<std::string> topic_table;
+    std::string payload;
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <pthread.h>
+#include <sched.h>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * CPU list as in taskset/cgroups: "0,2,4-7". Malformed entries are skipped.
+ */
+inline std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        char* end = nullptr;
+        long first = std::strtol(item.c_str(), &end, 10);
+        long last = first;
+        if (end && *end == '-') {
+            last = std::strtol(end + 1, &end, 10);
+        }
+        if (!end || *end != '\0' || first < 0 || last < first) {
+            continue;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back((int)cpu);
+        }
+    }
+    return cpus;
+}
+
+// Restrict a thread to one CPU; false when the CPU does not exist or is not allowed
+inline bool pin_thread_to_cpu(pthread_t thread, int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+}
+
+/**
+ * Pin the calling thread to cpu, unless an earlier call already pinned this same thread.
+ * For threads a library owns and may share between its clients (the Paho C async library
+ * delivers every client's messages on one receive thread): the first caller picks the CPU.
+ * Returns the CPU the thread is pinned to, -1 when pinning failed.
+ */
+inline int pin_current_thread_once(int cpu) {
+    static std::mutex mutex;
+    static std::vector<std::pair<pthread_t, int>> pinned;
+    std::lock_guard<std::mutex> lock(mutex);
+    pthread_t self = pthread_self();
+    for (const auto& entry : pinned) {
+        if (pthread_equal(entry.first, self)) {
+            return entry.second;
+        }
+    }
+    if (!pin_thread_to_cpu(self, cpu)) {
+        return -1;
+    }
+    pinned.emplace_back(self, cpu);
+    return cpu;
+}
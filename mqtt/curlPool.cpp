@@ -0,0 +1,96 @@
+#include "curlPool.h"
+
+// Callback for CURL response
+static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+    ((std::string*)userp)->append((char*)contents, size * nmemb);
+    return size * nmemb;
+}
+
+CurlPool::CurlPool(const std::string& base_url, size_t size, long timeout_ms)
+    : base_url(base_url), handles(size == 0 ? 1 : size) {
+    headers = curl_slist_append(headers, "Content-Type: application/json");
+    // Stop curl from waiting for "100 Continue" on larger bodies (bulk requests)
+    headers = curl_slist_append(headers, "Expect:");
+
+    idle.reserve(handles.size());
+    for (auto& handle : handles) {
+        handle.curl = curl_easy_init();
+        if (!handle.curl) {
+            continue;
+        }
+        curl_easy_setopt(handle.curl, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(handle.curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+        curl_easy_setopt(handle.curl, CURLOPT_WRITEDATA, &handle.response);
+        curl_easy_setopt(handle.curl, CURLOPT_TIMEOUT_MS, timeout_ms);
+        curl_easy_setopt(handle.curl, CURLOPT_NOSIGNAL, 1L);     // Required when used from several threads
+        curl_easy_setopt(handle.curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(handle.curl, CURLOPT_TCP_NODELAY, 1L);
+        curl_easy_setopt(handle.curl, CURLOPT_MAXCONNECTS, 1L);
+        idle.push_back(&handle);
+    }
+    usable = idle.size();
+}
+
+CurlPool::~CurlPool() {
+    for (auto& handle : handles) {
+        if (handle.curl) {
+            curl_easy_cleanup(handle.curl);
+        }
+    }
+    curl_slist_free_all(headers);
+}
+
+CurlPool::Handle* CurlPool::acquire() {
+    std::unique_lock<std::mutex> lock(idle_mutex);
+    idle_cv.wait(lock, [this] { return !idle.empty(); });
+    Handle* handle = idle.back();
+    idle.pop_back();
+    return handle;
+}
+
+void CurlPool::release(Handle* handle) {
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex);
+        idle.push_back(handle);
+    }
+    idle_cv.notify_one();
+}
+
+CurlPool::Response CurlPool::post(const std::string& endpoint, std::string_view json_payload) {
+    Response result;
+    if (usable == 0) {
+        result.code = CURLE_FAILED_INIT;
+        return result;
+    }
+
+    Handle* handle = acquire();
+    handle->url.assign(base_url).append(endpoint);
+    handle->response.clear();
+
+    curl_easy_setopt(handle->curl, CURLOPT_URL, handle->url.c_str());
+    curl_easy_setopt(handle->curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(handle->curl, CURLOPT_POSTFIELDS, json_payload.data());
+    curl_easy_setopt(handle->curl, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)json_payload.size());
+
+    result.code = curl_easy_perform(handle->curl);
+    curl_easy_getinfo(handle->curl, CURLINFO_RESPONSE_CODE, &result.http_code);
+    result.body.swap(handle->response);
+
+    release(handle);
+    return result;
+}
+
+size_t CurlPool::warm_up(const std::string& endpoint) {
+    std::lock_guard<std::mutex> lock(idle_mutex);
+    size_t connected = 0;
+    std::string url = base_url + endpoint;
+    for (Handle* handle : idle) {
+        curl_easy_setopt(handle->curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(handle->curl, CURLOPT_HTTPGET, 1L);
+        if (curl_easy_perform(handle->curl) == CURLE_OK) {
+            connected++;
+        }
+        handle->response.clear();
+    }
+    return connected;
+}
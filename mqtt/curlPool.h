@@ -0,0 +1,54 @@
+#pragma once
+#include <curl/curl.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Fixed pool of pre-configured CURL easy handles.
+ * Each handle keeps its connection open between requests (HTTP keep-alive),
+ * so a POST to FastAPI no longer pays for curl_easy_init, header building
+ * and a new TCP handshake every time.
+ */
+class CurlPool {
+public:
+    struct Response {
+        CURLcode code = CURLE_OK;
+        long http_code = 0;
+        std::string body;
+    };
+
+    CurlPool(const std::string& base_url, size_t size, long timeout_ms);
+    ~CurlPool();
+
+    CurlPool(const CurlPool&) = delete;
+    CurlPool& operator=(const CurlPool&) = delete;
+
+    // POST a JSON body to base_url + endpoint. Blocks while all handles are busy.
+    Response post(const std::string& endpoint, std::string_view json_payload);
+
+    // Open the connection of every handle up front (GET on endpoint, e.g. "/health")
+    size_t warm_up(const std::string& endpoint);
+
+    size_t size() const { return usable; }
+
+private:
+    struct Handle {
+        CURL* curl = nullptr;
+        std::string url;
+        std::string response;
+    };
+
+    Handle* acquire();
+    void release(Handle* handle);
+
+    std::string base_url;
+    struct curl_slist* headers = nullptr;   // Shared, read-only after construction
+    std::vector<Handle> handles;
+    size_t usable = 0;                      // Handles where curl_easy_init succeeded
+    std::vector<Handle*> idle;
+    std::mutex idle_mutex;
+    std::condition_variable idle_cv;
+};
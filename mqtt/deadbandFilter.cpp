@@ -0,0 +1,236 @@
+#include "deadbandFilter.h"
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <type_traits>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include "metrics.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+DeadbandRule read_rule(const json& entry) {
+    DeadbandRule rule;
+    rule.metric = entry.value("metric", "");
+    rule.absolute = std::fabs(entry.value("absolute", 0.0));
+    rule.percent = std::fabs(entry.value("percent", 0.0));
+    rule.max_silence_ms = (int64_t)(entry.value("max_silence_s", 0.0) * 1000);
+    return rule;
+}
+
+bool stored_number(const std::variant<std::monostate, bool, int64_t, uint64_t, double, std::string>& v,
+                   double& out) {
+    if (auto d = std::get_if<double>(&v)) {
+        out = *d;
+    } else if (auto i = std::get_if<int64_t>(&v)) {
+        out = (double)*i;
+    } else if (auto u = std::get_if<uint64_t>(&v)) {
+        out = (double)*u;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int64_t wall_ms_now() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+DeadbandOptions DeadbandOptions::load(const std::string& path) {
+    DeadbandOptions options;
+    if (path.empty()) {
+        return options;
+    }
+    std::ifstream in(path);
+    if (!in) {
+        spdlog::error("Cannot open deadband file {}, deadband filtering is off", path);
+        return options;
+    }
+    json doc = json::parse(in, nullptr, false);
+    if (doc.is_discarded() || !doc.is_object()) {
+        spdlog::error("Deadband file {} is not a JSON object, deadband filtering is off", path);
+        return options;
+    }
+    if (doc.contains("default") && doc["default"].is_object()) {
+        options.has_default = true;
+        options.default_rule = read_rule(doc["default"]);
+        options.default_rule.metric = "*";
+    }
+    if (doc.contains("metrics") && doc["metrics"].is_array()) {
+        for (const auto& entry : doc["metrics"]) {
+            DeadbandRule rule = read_rule(entry);
+            if (rule.metric.empty()) {
+                spdlog::error("Deadband file {}: rule without \"metric\", skipped", path);
+                continue;
+            }
+            options.rules.push_back(std::move(rule));
+        }
+    }
+    return options;
+}
+
+DeadbandFilter::DeadbandFilter(DeadbandOptions options) : options(std::move(options)) {}
+
+const DeadbandRule* DeadbandFilter::rule_for(std::string_view metric) const {
+    for (const DeadbandRule& rule : options.rules) {
+        std::string_view pattern = rule.metric;
+        if (!pattern.empty() && pattern.back() == '*') {
+            pattern.remove_suffix(1);
+            if (metric.substr(0, pattern.size()) == pattern) {
+                return &rule;
+            }
+        } else if (metric == pattern) {
+            return &rule;
+        }
+    }
+    return options.has_default ? &options.default_rule : nullptr;
+}
+
+bool DeadbandFilter::passes(const MetricState& state, const DecodedMetric& metric, int64_t now_ms) {
+    const DeadbandRule& rule = *state.rule;
+    if (rule.max_silence_ms > 0 && now_ms - state.sent_ms >= rule.max_silence_ms) {
+        return true;
+    }
+    double last;
+    if (metric.is_number() && stored_number(state.value, last)) {
+        double delta = std::fabs(metric.as_double() - last);
+        if (rule.absolute <= 0 && rule.percent <= 0) {
+            return delta != 0;
+        }
+        return (rule.absolute > 0 && delta > rule.absolute) ||
+               (rule.percent > 0 && delta > std::fabs(last) * rule.percent / 100.0);
+    }
+    // Booleans, strings, or a change of type
+    return std::visit([&state](const auto& v) {
+        using V = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<V, std::string_view>) {
+            auto s = std::get_if<std::string>(&state.value);
+            return !s || *s != v;
+        } else {
+            auto s = std::get_if<V>(&state.value);
+            return !s || !(*s == v);
+        }
+    }, metric.value);
+}
+
+DecodedMessage::Ptr DeadbandFilter::filter(const DecodedMessage::Ptr& msg) {
+    const SparkplugTopic& topic = msg->topic;
+    bool birth = topic.type == MessageType::NBIRTH || topic.type == MessageType::DBIRTH;
+    bool data = topic.type == MessageType::DDATA || topic.type == MessageType::NDATA;
+    if (!msg->ok || (!birth && !data) || !enabled()) {
+        return msg;
+    }
+
+    std::string key;
+    key.reserve(topic.group_id.size() + topic.node_id.size() + 1);
+    key.append(topic.group_id);
+    key += '/';
+    key.append(topic.node_id);
+    Stripe& stripe = stripes[std::hash<std::string>{}(key) % STRIPES];
+
+    // "device|metric" of metrics without an index
+    std::string name_key;
+    name_key.append(topic.device_id);
+    name_key += '|';
+    const size_t prefix = name_key.size();
+
+    std::vector<DecodedMetric> kept;
+    kept.reserve(msg->metrics.size());
+    uint64_t suppressed = 0;
+    uint64_t heartbeats = 0;
+    const int64_t wall_ms = wall_ms_now();
+    {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        NodeState& node = stripe.nodes[key];
+        for (const DecodedMetric& metric : msg->metrics) {
+            if (!metric.has_value()) {
+                kept.push_back(metric);
+                continue;
+            }
+            int64_t now_ms = metric.timestamp_ms > 0 ? metric.timestamp_ms : wall_ms;
+            StoredValue value = std::visit([](const auto& v) -> StoredValue {
+                using V = std::decay_t<decltype(v)>;
+                if constexpr (std::is_same_v<V, std::string_view>) {
+                    return std::string(v);
+                } else {
+                    return v;
+                }
+            }, metric.value);
+
+            MetricState* slot;
+            if (metric.has_index()) {
+                if (metric.index >= node.by_index.size()) {
+                    node.by_index.resize(metric.index + 1);
+                }
+                slot = &node.by_index[metric.index];
+            } else {
+                name_key.resize(prefix);
+                if (!metric.name.empty()) {
+                    name_key.append(metric.name);
+                } else {
+                    name_key += '#';
+                    name_key += std::to_string(metric.alias);
+                }
+                slot = &node.by_name[name_key];
+            }
+            MetricState& state = *slot;
+            if (!state.seen) {
+                state = MetricState{std::move(value), now_ms, rule_for(metric.name), true};
+                kept.push_back(metric);
+                continue;
+            }
+            if (birth || !state.rule) {
+                state.value = std::move(value);
+                state.sent_ms = now_ms;
+                kept.push_back(metric);
+                continue;
+            }
+            if (passes(state, metric, now_ms)) {
+                if (state.value == value) {
+                    heartbeats++;
+                }
+                state.value = std::move(value);
+                state.sent_ms = now_ms;
+                kept.push_back(metric);
+            } else {
+                suppressed++;
+            }
+        }
+    }
+
+    if (birth) {
+        return msg;
+    }
+    PipelineMetrics::DeadbandCounters& counters = pipeline_metrics().deadband;
+    counters.forwarded.fetch_add(kept.size(), std::memory_order_relaxed);
+    counters.suppressed.fetch_add(suppressed, std::memory_order_relaxed);
+    counters.heartbeats.fetch_add(heartbeats, std::memory_order_relaxed);
+    if (suppressed == 0) {
+        return msg;
+    }
+    if (kept.empty()) {
+        counters.messages_dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return DecodedMessage::with_metrics(msg, std::move(kept));
+}
+
+size_t DeadbandFilter::tracked() const {
+    size_t count = 0;
+    for (const Stripe& stripe : stripes) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        for (const auto& entry : stripe.nodes) {
+            count += entry.second.by_name.size();
+            for (const MetricState& state : entry.second.by_index) {
+                count += state.seen ? 1 : 0;
+            }
+        }
+    }
+    return count;
+}
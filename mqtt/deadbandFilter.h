@@ -0,0 +1,97 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+#include "decodedMessage.h"
+
+/**
+ * Deadband of one metric (or of every metric matching a name prefix ending in '*'):
+ * a numeric value is forwarded when it moved more than `absolute` or more than `percent` of
+ * the last forwarded value; with both 0 any change is forwarded. Non numeric values are
+ * forwarded when they change. Whatever the value, a metric is forwarded again once it has been
+ * silent for max_silence_ms (0 = never), so dashboards and gap checks keep seeing it.
+ */
+struct DeadbandRule {
+    std::string metric;
+    double absolute = 0;
+    double percent = 0;
+    int64_t max_silence_ms = 0;
+};
+
+/**
+ * Rules from DEADBAND_FILE:
+ *   {"default": {"absolute": 0, "max_silence_s": 900},
+ *    "metrics": [{"metric": "Inputs/Outdoor_temperature", "absolute": 0.2, "max_silence_s": 300}, ...]}
+ * Metrics matching no rule use "default"; without a "default" they are not filtered.
+ * Not available with MQTT_SHARE_GROUP: an instance only sees part of a node's data, so its
+ * last values are not the ones stored.
+ */
+struct DeadbandOptions {
+    std::vector<DeadbandRule> rules;
+    bool has_default = false;
+    DeadbandRule default_rule;
+
+    bool empty() const { return rules.empty() && !has_default; }
+
+    // Empty (filter off) when path is empty or the file is unusable
+    static DeadbandOptions load(const std::string& path);
+};
+
+/**
+ * Report by exception in front of the sinks. DDATA/NDATA metrics are compared with the last
+ * value forwarded for the same (group, node, device, metric); a message keeps only its metrics
+ * that pass their rule, and is dropped when none does. NBIRTH/DBIRTH pass untouched and seed
+ * the last values of their metrics, so the first DDATA after a birth is filtered against it.
+ *
+ * State is O(1) per metric: one hash lookup per message finds the node in lock striped
+ * tables, then metrics are indexed by DecodedMetric::index (by name only when unindexed).
+ * Each holds the last forwarded value, its source timestamp and the resolved rule. Silence is
+ * measured in the metric's own Sparkplug timestamps, so a replayed capture filters like the
+ * original stream.
+ */
+class DeadbandFilter {
+public:
+    explicit DeadbandFilter(DeadbandOptions options);
+
+    DeadbandFilter(const DeadbandFilter&) = delete;
+    DeadbandFilter& operator=(const DeadbandFilter&) = delete;
+
+    bool enabled() const { return !options.empty(); }
+
+    // The message to forward: `msg` itself, a copy with fewer metrics, or nullptr for none
+    DecodedMessage::Ptr filter(const DecodedMessage::Ptr& msg);
+
+    size_t tracked() const;
+
+private:
+    using StoredValue = std::variant<std::monostate, bool, int64_t, uint64_t, double, std::string>;
+
+    struct MetricState {
+        StoredValue value;
+        int64_t sent_ms = 0;
+        const DeadbandRule* rule = nullptr;     // nullptr = not filtered
+        bool seen = false;
+    };
+
+    struct NodeState {
+        std::vector<MetricState> by_index;                      // DecodedMetric::index
+        std::unordered_map<std::string, MetricState> by_name;   // "device|metric" of unindexed metrics
+    };
+
+    struct Stripe {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, NodeState> nodes;       // "group/node"
+    };
+
+    static constexpr size_t STRIPES = 16;
+
+    const DeadbandRule* rule_for(std::string_view metric) const;
+    static bool passes(const MetricState& state, const DecodedMetric& metric, int64_t now_ms);
+
+    DeadbandOptions options;
+    std::array<Stripe, STRIPES> stripes;
+};
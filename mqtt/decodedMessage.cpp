@@ -0,0 +1,263 @@
+#include "decodedMessage.h"
+#include <type_traits>
+#include <utility>
+#include "metricAliasTable.h"
+#include "sparkplugProto.h"
+
+using json = nlohmann::json;
+
+double DecodedMetric::as_double() const {
+    if (auto v = std::get_if<double>(&value)) return *v;
+    if (auto v = std::get_if<int64_t>(&value)) return (double)*v;
+    if (auto v = std::get_if<uint64_t>(&value)) return (double)*v;
+    return 0.0;
+}
+
+int64_t DecodedMetric::as_int64() const {
+    if (auto v = std::get_if<int64_t>(&value)) return *v;
+    if (auto v = std::get_if<uint64_t>(&value)) return (int64_t)*v;
+    if (auto v = std::get_if<double>(&value)) return (int64_t)*v;
+    return 0;
+}
+
+std::string DecodedMetric::value_string() const {
+    if (auto v = std::get_if<bool>(&value)) return *v ? "true" : "false";
+    if (auto v = std::get_if<std::string_view>(&value)) return std::string(*v);
+    if (auto v = std::get_if<int64_t>(&value)) return std::to_string(*v);
+    if (auto v = std::get_if<uint64_t>(&value)) return std::to_string(*v);
+    if (auto v = std::get_if<double>(&value)) return std::to_string(*v);
+    return "unknown_type";
+}
+
+namespace {
+
+// paho-pub sends seconds, Sparkplug B specifies milliseconds; anything below 1e11 is taken as seconds
+int64_t epoch_to_ms(int64_t t) {
+    return (t > -100000000000LL && t < 100000000000LL) ? t * 1000 : t;
+}
+
+bool is_json_start(std::string_view payload) {
+    for (char c : payload) {
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            continue;
+        }
+        return c == '{';
+    }
+    return false;
+}
+
+bool read_int(const json& obj, const char* key, int64_t& out) {
+    auto it = obj.find(key);
+    if (it == obj.end() || !it->is_number()) {
+        return false;
+    }
+    out = it->is_number_float() ? (int64_t)it->get<double>() : it->get<int64_t>();
+    return true;
+}
+
+std::string_view string_field(const json& obj, const char* key) {
+    auto it = obj.find(key);
+    if (it == obj.end() || !it->is_string()) {
+        return std::string_view();
+    }
+    return it->get_ref<const std::string&>();
+}
+
+DecodedMetric::Value to_value(const json& v) {
+    switch (v.type()) {
+    case json::value_t::boolean: return v.get<bool>();
+    case json::value_t::number_unsigned: return v.get<uint64_t>();
+    case json::value_t::number_integer: return v.get<int64_t>();
+    case json::value_t::number_float: return v.get<double>();
+    case json::value_t::string: return std::string_view(v.get_ref<const std::string&>());
+    default: return std::monostate();
+    }
+}
+
+}  // namespace
+
+const char* payload_format_name(PayloadFormat format) {
+    switch (format) {
+    case PayloadFormat::Json: return "json";
+    case PayloadFormat::Protobuf: return "protobuf";
+    case PayloadFormat::Cbor: return "cbor";
+    default: return "msgpack";
+    }
+}
+
+PayloadFormat detect_payload_format(std::string_view payload) {
+    if (is_json_start(payload)) {
+        return PayloadFormat::Json;
+    }
+    if (payload.empty()) {
+        return PayloadFormat::Protobuf;
+    }
+    // A protobuf Payload starts with the tag of field 1-5 (0x08..0x2a), so the map headers are free:
+    // CBOR major type 5 (0xa0..0xbb, 0xbf indefinite), MessagePack fixmap (0x80..0x8f), map16/32 (0xde, 0xdf)
+    uint8_t first = (uint8_t)payload[0];
+    if ((first >= 0xa0 && first <= 0xbb) || first == 0xbf) {
+        return PayloadFormat::Cbor;
+    }
+    if ((first >= 0x80 && first <= 0x8f) || first == 0xde || first == 0xdf) {
+        return PayloadFormat::MessagePack;
+    }
+    return PayloadFormat::Protobuf;
+}
+
+DecodedMessage::Ptr DecodedMessage::decode(std::shared_ptr<const void> owner, const SparkplugTopic& topic,
+                                           std::string_view payload, std::chrono::steady_clock::time_point arrived,
+                                           MetricAliasTable* aliases, AckGate::Ticket ack) {
+    std::shared_ptr<DecodedMessage> msg(new DecodedMessage());
+    msg->owner = std::move(owner);
+    msg->ack = std::move(ack);
+    msg->topic = topic;
+    msg->payload = payload;
+    msg->arrived = arrived;
+    msg->format = detect_payload_format(payload);
+    switch (msg->format) {
+    case PayloadFormat::Json:
+        msg->decode_json();
+        break;
+    case PayloadFormat::Cbor:
+    case PayloadFormat::MessagePack:
+        msg->decode_binary_json();
+        break;
+    default:
+        msg->decode_protobuf();
+        break;
+    }
+    if (aliases && msg->ok) {
+        bool named = false;
+        msg->names = aliases->resolve(msg->topic, msg->metrics, named);
+        if (named) {
+            msg->render_json(msg->rendered);
+            msg->payload = msg->rendered;
+            msg->format = PayloadFormat::Json;
+        }
+    }
+    return msg;
+}
+
+DecodedMessage::Ptr DecodedMessage::decode(std::string topic, std::string payload,
+                                           std::chrono::steady_clock::time_point arrived) {
+    auto bytes = std::make_shared<std::pair<std::string, std::string>>(std::move(topic), std::move(payload));
+    return decode(bytes, parse_sparkplug_topic(bytes->first), bytes->second, arrived);
+}
+
+void DecodedMessage::decode_json() {
+    try {
+        document = json::parse(payload.begin(), payload.end());
+    } catch (const json::exception& e) {
+        error = e.what();
+        return;
+    }
+    read_document();
+}
+
+// Same document as the JSON, binary encoded: decoded straight into the json value, then read alike
+void DecodedMessage::decode_binary_json() {
+    try {
+        document = format == PayloadFormat::Cbor ? json::from_cbor(payload.begin(), payload.end())
+                                                 : json::from_msgpack(payload.begin(), payload.end());
+    } catch (const json::exception& e) {
+        error = e.what();
+        return;
+    }
+    read_document();
+}
+
+void DecodedMessage::read_document() {
+    if (!document.is_object()) {
+        error = "payload is not a JSON object";
+        return;
+    }
+
+    has_timestamp = read_int(document, "timestamp", timestamp_ms);
+    timestamp_ms = epoch_to_ms(timestamp_ms);
+    has_seq = read_int(document, "seq", seq);
+
+    auto list = document.find("metrics");
+    if (list != document.end() && list->is_array()) {
+        metrics.reserve(list->size());
+        for (const json& m : *list) {
+            if (!m.is_object()) {
+                continue;
+            }
+            DecodedMetric metric;
+            metric.name = string_field(m, "name");
+            metric.data_type = string_field(m, "dataType");
+            metric.has_alias = m.contains("alias") && m["alias"].is_number_unsigned();
+            if (metric.has_alias) {
+                metric.alias = m["alias"].get<uint64_t>();
+            }
+            if (read_int(m, "timestamp", metric.timestamp_ms)) {
+                metric.timestamp_ms = epoch_to_ms(metric.timestamp_ms);
+            } else {
+                metric.timestamp_ms = timestamp_ms;
+            }
+            auto value = m.find("value");
+            if (value != m.end()) {
+                metric.value = to_value(*value);
+            }
+            metrics.push_back(metric);
+        }
+    }
+    ok = true;
+}
+
+void DecodedMessage::decode_protobuf() {
+    ok = decode_sparkplug_protobuf(payload, *this, error);
+}
+
+DecodedMessage::Ptr DecodedMessage::with_metrics(const Ptr& source, std::vector<DecodedMetric> metrics) {
+    std::shared_ptr<DecodedMessage> msg(new DecodedMessage());
+    msg->owner = source;
+    msg->topic = source->topic;
+    msg->arrived = source->arrived;
+    msg->ok = source->ok;
+    msg->error = source->error;
+    msg->timestamp_ms = source->timestamp_ms;
+    msg->has_timestamp = source->has_timestamp;
+    msg->seq = source->seq;
+    msg->has_seq = source->has_seq;
+    msg->ack = source->ack;
+    msg->metrics = std::move(metrics);
+    msg->render_json(msg->rendered);
+    msg->payload = msg->rendered;
+    msg->format = PayloadFormat::Json;
+    return msg;
+}
+
+std::string_view DecodedMessage::as_json(std::string& scratch) const {
+    if (format == PayloadFormat::Json) {
+        return payload;
+    }
+    render_json(scratch);
+    return scratch;
+}
+
+void DecodedMessage::render_json(std::string& out_json) const {
+    json out;
+    out["timestamp"] = timestamp_ms;
+    out["seq"] = seq;
+    json& list = out["metrics"] = json::array();
+    for (const DecodedMetric& metric : metrics) {
+        if (metric.name.empty() || !metric.has_value()) {
+            continue;
+        }
+        json m;
+        m["name"] = std::string(metric.name);
+        m["timestamp"] = metric.timestamp_ms;
+        m["dataType"] = std::string(metric.data_type);
+        std::visit([&m](const auto& v) {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<T, std::string_view>) {
+                m["value"] = std::string(v);
+            } else if constexpr (!std::is_same_v<T, std::monostate>) {
+                m["value"] = v;
+            }
+        }, metric.value);
+        list.push_back(std::move(m));
+    }
+    out_json = out.dump(-1, ' ', false, json::error_handler_t::replace);   // Protobuf strings are not UTF-8 checked
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "ackGate.h"
+#include "sparkplugTopic.h"
+
+class MetricAliasTable;
+
+/**
+ * One metric of a Sparkplug payload. Names and string values are views into the
+ * owning DecodedMessage and are only valid as long as it is.
+ */
+struct DecodedMetric {
+    using Value = std::variant<std::monostate, bool, int64_t, uint64_t, double, std::string_view>;
+
+    static constexpr uint32_t NO_INDEX = UINT32_MAX;
+
+    std::string_view name;         // May be empty when the node only sends the alias
+    std::string_view data_type;    // "Float", "UInt64", ... as sent by the node; may be empty
+    uint64_t alias = 0;
+    bool has_alias = false;
+    int64_t timestamp_ms = 0;      // Milliseconds since epoch; falls back to the payload timestamp
+    uint32_t index = NO_INDEX;     // Slot of (device, metric) in its node's MetricAliasTable
+    Value value;
+
+    bool has_index() const { return index != NO_INDEX; }
+
+    bool has_value() const { return !std::holds_alternative<std::monostate>(value); }
+    bool is_bool() const { return std::holds_alternative<bool>(value); }
+    bool is_string() const { return std::holds_alternative<std::string_view>(value); }
+    bool is_number() const {
+        return std::holds_alternative<int64_t>(value) || std::holds_alternative<uint64_t>(value) ||
+               std::holds_alternative<double>(value);
+    }
+
+    // Numeric value converted to double/int64 (0 for non numbers)
+    double as_double() const;
+    int64_t as_int64() const;
+    std::string value_string() const;
+};
+
+enum class PayloadFormat {
+    Json,        // Sparkplug JSON as published by paho-pub
+    Protobuf,    // org.eclipse.tahu.protobuf.Payload, what real Sparkplug B nodes send
+    Cbor,        // The Sparkplug JSON document as CBOR (PAYLOAD_ENCODING=cbor)
+    MessagePack  // The Sparkplug JSON document as MessagePack (PAYLOAD_ENCODING=msgpack)
+};
+
+const char* payload_format_name(PayloadFormat format);
+
+// Told apart by the first byte: '{' for JSON, a map header for CBOR/MessagePack, else protobuf
+PayloadFormat detect_payload_format(std::string_view payload);
+
+/**
+ * A Sparkplug message decoded once on the ingest worker and shared read-only by
+ * security analysis and every sink. The topic and payload bytes are not copied:
+ * `owner` (the MQTT message) keeps them alive for as long as this object lives.
+ * The payload format is detected from the first byte, all of them give the same metrics.
+ */
+class DecodedMessage {
+public:
+    using Ptr = std::shared_ptr<const DecodedMessage>;
+
+    SparkplugTopic topic;
+    std::string_view payload;                          // Raw bytes as received
+    PayloadFormat format = PayloadFormat::Json;
+    std::chrono::steady_clock::time_point arrived;
+
+    bool ok = false;                                   // Payload decoded
+    std::string error;                                 // Why not, when !ok
+    int64_t timestamp_ms = 0;                          // Milliseconds since epoch
+    bool has_timestamp = false;
+    int64_t seq = 0;
+    bool has_seq = false;
+    std::vector<DecodedMetric> metrics;
+    AckGate::Ticket ack;                               // QoS 1 only: in-flight slot, freed when every copy is gone
+
+    /**
+     * The payload as Sparkplug JSON: the raw bytes when it arrived as JSON, otherwise
+     * rendered from the metrics into `scratch` (metrics without a name or value are left out).
+     */
+    std::string_view as_json(std::string& scratch) const;
+
+    DecodedMessage(const DecodedMessage&) = delete;
+    DecodedMessage& operator=(const DecodedMessage&) = delete;
+
+    /**
+     * Decode a payload whose topic was already parsed. `topic` and `payload` must point into
+     * memory kept alive by `owner`. With `aliases` every metric gets its slot index and alias
+     * only metrics their name; the payload of such a message is then rendered as JSON with the
+     * names, like with_metrics(), so sinks and the spool never see a bare alias.
+     * `ack` is the message's AckGate ticket, shared with every message derived from it.
+     */
+    static Ptr decode(std::shared_ptr<const void> owner, const SparkplugTopic& topic,
+                      std::string_view payload, std::chrono::steady_clock::time_point arrived,
+                      MetricAliasTable* aliases = nullptr, AckGate::Ticket ack = nullptr);
+
+    /**
+     * The same message carrying only `metrics` (views into `source`, which the result keeps
+     * alive). Its payload is those metrics rendered as compact Sparkplug JSON, so sinks and
+     * the spool that use the raw bytes see the reduced message too.
+     */
+    static Ptr with_metrics(const Ptr& source, std::vector<DecodedMetric> metrics);
+
+    // Convenience for tools and benchmarks: takes ownership of the strings
+    static Ptr decode(std::string topic, std::string payload,
+                      std::chrono::steady_clock::time_point arrived = std::chrono::steady_clock::now());
+
+private:
+    DecodedMessage() = default;
+    void decode_json();
+    void decode_binary_json();
+    void read_document();
+    void decode_protobuf();
+    void render_json(std::string& out) const;
+
+    std::shared_ptr<const void> owner;
+    nlohmann::json document;                           // JSON/CBOR/MessagePack: owns the strings the metric views point at
+    std::string rendered;                              // Payload of with_metrics() and alias resolved messages
+    std::shared_ptr<const void> names;                 // MetricAliasTable names the resolved metrics point at
+};
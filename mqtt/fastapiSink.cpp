@@ -0,0 +1,114 @@
+#include "fastapiSink.h"
+#include <spdlog/spdlog.h>
+#include <nlohmann/json.hpp>
+
+FastApiSink::FastApiSink(const std::string& base_url, size_t pool_size, long timeout_ms)
+    : pool(base_url, pool_size, timeout_ms) {
+    // Open the keep-alive connections before the first message arrives
+    size_t warm = pool.warm_up("/health");
+    spdlog::info("FastAPI connection pool ready: {}/{} connections open", warm, pool.size());
+}
+
+WriteResult FastApiSink::post(const std::string& endpoint, std::string_view body) {
+    CurlPool::Response res = pool.post(endpoint, body);
+    
+    if (res.code != CURLE_OK) {
+        spdlog::error("Failed to send to FastAPI {}: {}", endpoint, curl_easy_strerror(res.code));
+        return WriteResult::Retry;
+    }
+    
+    if (res.http_code >= 200 && res.http_code < 300) {
+        spdlog::debug("FastAPI {} success (HTTP {}): {}", endpoint, res.http_code, res.body);
+        return WriteResult::Ok;
+    }
+    spdlog::error("FastAPI {} error (HTTP {}): {}", endpoint, res.http_code, res.body);
+    // Server trouble or throttling may pass; any other 4xx will refuse the same body again
+    if (res.http_code >= 500 || res.http_code == 429 || res.http_code < 400) {
+        return WriteResult::Retry;
+    }
+    return WriteResult::Reject;
+}
+
+namespace {
+void append_json_string(std::string& out, std::string_view s) {
+    out += nlohmann::json(std::string(s)).dump();
+}
+}
+
+std::string FastApiSink::build_bulk_body(const std::vector<const DecodedMessage*>& messages) {
+    size_t size = 16;
+    for (const DecodedMessage* m : messages) {
+        const SparkplugTopic& t = m->topic;
+        size += m->payload.size() + t.group_id.size() + t.node_id.size() + t.device_id.size() + 64;
+    }
+
+    std::string body;
+    std::string scratch;
+    body.reserve(size);
+    body += "{\"messages\":[";
+    for (size_t i = 0; i < messages.size(); ++i) {
+        const DecodedMessage* m = messages[i];
+        if (i > 0) {
+            body += ',';
+        }
+        body += "{\"group_id\":";
+        append_json_string(body, m->topic.group_id);
+        body += ",\"node_id\":";
+        append_json_string(body, m->topic.node_id);
+        body += ",\"device_id\":";
+        append_json_string(body, m->topic.device_id);
+        body += ",\"payload\":";
+        body += m->as_json(scratch);     // JSON payloads are spliced in unchanged
+        body += '}';
+    }
+    body += "]}";
+    return body;
+}
+
+WriteResult FastApiSink::flush_bulk(std::vector<const DecodedMessage*>& bulk) {
+    if (bulk.empty()) {
+        return WriteResult::Ok;
+    }
+    WriteResult result = post("/ingest/ddata/bulk", build_bulk_body(bulk));
+    bulk.clear();
+    return result;
+}
+
+bool FastApiSink::needs_own_batch(const DecodedMessage& msg) const {
+    return msg.topic.type == MessageType::NBIRTH || msg.topic.type == MessageType::NDEATH;
+}
+
+WriteResult FastApiSink::write_batch(const std::vector<SinkMessagePtr>& batch) {
+    std::vector<const DecodedMessage*> bulk;
+    bulk.reserve(batch.size());
+
+    for (const auto& msg : batch) {
+        const SparkplugTopic& t = msg->topic;
+        if (!msg->ok) {
+            // FastAPI would reject the whole bulk request over one bad payload
+            spdlog::warn("FastAPI sink: skipping undecodable payload on {}", t.topic);
+            continue;
+        }
+        if (t.type == MessageType::DDATA || t.type == MessageType::NDATA) {
+            bulk.push_back(msg.get());
+            continue;
+        }
+        if (t.type != MessageType::NBIRTH && t.type != MessageType::NDEATH) {
+            continue;   // No FastAPI endpoint for DBIRTH/DDEATH, the file sink keeps them
+        }
+
+        // Keep ordering: data collected so far goes out before the birth/death
+        WriteResult result = flush_bulk(bulk);
+        if (result != WriteResult::Ok) {
+            return result;
+        }
+        std::string node_path = std::string(t.group_id) + "/" + std::string(t.node_id);
+        std::string scratch;
+        const char* endpoint = t.type == MessageType::NBIRTH ? "/ingest/nbirth/" : "/ingest/ndeath/";
+        result = post(endpoint + node_path, msg->as_json(scratch));
+        if (result != WriteResult::Ok) {
+            return result;
+        }
+    }
+    return flush_bulk(bulk);
+}
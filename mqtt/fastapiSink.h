@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "curlPool.h"
+#include "sink.h"
+
+/**
+ * Sink that forwards to the FastAPI service.
+ * DDATA and NDATA of a batch are sent as one POST to /ingest/ddata/bulk,
+ * NBIRTH and NDEATH go to their own endpoints, in arrival order; DBIRTH/DDEATH have none and
+ * are skipped. Node births and deaths come in batches of their own, so every batch from
+ * SinkRunner is at most one POST and a retry never inserts the bulk rows twice.
+ * Transport errors, 5xx and 429 are retried; any other 4xx rejects the batch for good.
+ */
+class FastApiSink : public Sink {
+public:
+    FastApiSink(const std::string& base_url, size_t pool_size, long timeout_ms);
+
+    std::string name() const override { return "fastapi"; }
+    WriteResult write_batch(const std::vector<SinkMessagePtr>& batch) override;
+    bool needs_own_batch(const DecodedMessage& msg) const override;
+
+    static std::string build_bulk_body(const std::vector<const DecodedMessage*>& messages);
+
+private:
+    WriteResult post(const std::string& endpoint, std::string_view body);
+    WriteResult flush_bulk(std::vector<const DecodedMessage*>& bulk);
+
+    CurlPool pool;
+};
@@ -0,0 +1,55 @@
+#include "fileSink.h"
+#include <spdlog/spdlog.h>
+#include <nlohmann/json.hpp>
+
+FileSink::FileSink(const std::string& path) : path(path) {
+    file = std::fopen(path.c_str(), "ab");
+    if (!file) {
+        spdlog::error("File sink could not open {}", path);
+    }
+}
+
+FileSink::~FileSink() {
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+WriteResult FileSink::write_batch(const std::vector<SinkMessagePtr>& batch) {
+    if (!file) {
+        file = std::fopen(path.c_str(), "ab");
+        if (!file) {
+            return WriteResult::Retry;
+        }
+    }
+
+    for (const auto& msg : batch) {
+        if (!msg->ok) {
+            continue;   // Would break the JSON line
+        }
+        line.clear();
+        line += "{\"type\":\"";
+        line += message_type_name(msg->topic.type);
+        line += "\",\"group_id\":";
+        line += nlohmann::json(std::string(msg->topic.group_id)).dump();
+        line += ",\"node_id\":";
+        line += nlohmann::json(std::string(msg->topic.node_id)).dump();
+        line += ",\"device_id\":";
+        line += nlohmann::json(std::string(msg->topic.device_id)).dump();
+        line += ",\"payload\":";
+        size_t start = line.size();
+        line += msg->as_json(scratch);
+        // Keep one message per line; raw newlines can only be insignificant whitespace in valid JSON
+        for (size_t i = start; i < line.size(); ++i) {
+            if (line[i] == '\n' || line[i] == '\r') {
+                line[i] = ' ';
+            }
+        }
+        line += "}\n";
+        if (std::fwrite(line.data(), 1, line.size(), file) != line.size()) {
+            spdlog::error("File sink write to {} failed", path);
+            return WriteResult::Retry;
+        }
+    }
+    return std::fflush(file) == 0 ? WriteResult::Ok : WriteResult::Retry;
+}
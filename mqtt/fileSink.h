@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "sink.h"
+
+/**
+ * Appends every message as one JSON line to a local file
+ * ({"type":..,"group_id":..,"node_id":..,"device_id":..,"payload":{...}}).
+ * Useful as an audit trail or for replaying into another system.
+ */
+class FileSink : public Sink {
+public:
+    explicit FileSink(const std::string& path);
+    ~FileSink() override;
+
+    std::string name() const override { return "file"; }
+    WriteResult write_batch(const std::vector<SinkMessagePtr>& batch) override;
+
+private:
+    std::string path;
+    FILE* file = nullptr;
+    std::string line;
+    std::string scratch;        // JSON rendering of non-JSON payloads
+};
@@ -0,0 +1,137 @@
+#include "ilpSink.h"
+#include <ctime>
+#include <spdlog/spdlog.h>
+
+using namespace questdb::ingress::literals;
+
+namespace {
+const auto NODE_COLUMN = "node_name"_cn;
+const auto DEVICE_COLUMN = "device_name"_cn;
+const auto VALUE_COLUMN = "value"_cn;
+const auto STATUS_COLUMN = "status"_cn;
+}
+
+std::string sanitize_table_name(const std::string& metric_name) {
+    // "Inputs/Indoor_temperature" -> "indoor_temperature"
+    size_t slash = metric_name.find('/');
+    std::string name = slash == std::string::npos ? metric_name : metric_name.substr(slash + 1);
+    for (char& c : name) {
+        if (c >= 'A' && c <= 'Z') {
+            c = (char)(c - 'A' + 'a');
+        }
+        if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_')) {
+            c = '_';
+        }
+    }
+    return name;
+}
+
+IlpSink::IlpSink(const std::string& sink_name, const std::string& conf)
+    : sink_name(sink_name), conf(conf) {
+    ensure_sender();
+}
+
+bool IlpSink::ensure_sender() {
+    if (sender && !sender->must_close()) {
+        return true;
+    }
+    try {
+        sender.reset();
+        sender.emplace(questdb::ingress::line_sender::from_conf(conf));
+        if (!buffer) {
+            buffer.emplace(sender->new_buffer());
+        }
+        spdlog::info("{} connected ({})", sink_name, conf);
+        return true;
+    } catch (const questdb::ingress::line_sender_error& err) {
+        spdlog::error("{} connect failed: {}", sink_name, err.what());
+        sender.reset();
+        return false;
+    }
+}
+
+const questdb::ingress::table_name_view& IlpSink::table_for(std::string_view metric_name) {
+    auto it = tables.find(metric_name);
+    if (it == tables.end()) {
+        auto key = std::make_unique<const std::string>(metric_name);
+        std::string_view key_view(*key);
+        TableEntry entry{std::move(key), sanitize_table_name(std::string(metric_name)), std::nullopt};
+        it = tables.emplace(key_view, std::move(entry)).first;
+        // Validate once; the map node (and thus the string) never moves afterwards
+        it->second.view.emplace(it->second.name);
+    }
+    return *it->second.view;
+}
+
+void IlpSink::append_row(const questdb::ingress::table_name_view& table, const SparkplugTopic& topic,
+                         const DecodedMetric& metric) {
+    buffer->table(table).symbol(NODE_COLUMN, questdb::ingress::utf8_view{topic.node_id});
+    if (topic.is_device()) {
+        buffer->symbol(DEVICE_COLUMN, questdb::ingress::utf8_view{topic.device_id});
+    }
+
+    if (auto v = std::get_if<bool>(&metric.value)) {
+        buffer->column(VALUE_COLUMN, *v);
+    } else if (auto v = std::get_if<double>(&metric.value)) {
+        buffer->column(VALUE_COLUMN, *v);
+    } else if (auto v = std::get_if<std::string_view>(&metric.value)) {
+        buffer->column(STATUS_COLUMN, *v);
+    } else {
+        buffer->column(VALUE_COLUMN, metric.as_int64());
+    }
+
+    // DecodedMessage normalizes timestamps to milliseconds for both payload formats
+    int64_t timestamp_ms = metric.timestamp_ms ? metric.timestamp_ms : (int64_t)std::time(nullptr) * 1000;
+    buffer->at(questdb::ingress::timestamp_micros{timestamp_ms * 1000});
+}
+
+void IlpSink::append_message(const DecodedMessage& msg) {
+    if (!msg.ok) {
+        spdlog::error("ILP sink: undecodable payload from {}/{}: {}", msg.topic.node_id, msg.topic.device_id, msg.error);
+        return;
+    }
+
+    for (const DecodedMetric& metric : msg.metrics) {
+        if (metric.name.empty() || !metric.has_value()) {
+            continue;
+        }
+        try {
+            buffer->set_marker();
+            append_row(table_for(metric.name), msg.topic, metric);
+        } catch (const questdb::ingress::line_sender_error& err) {
+            // Invalid name or value: undo the half-written row and drop this metric only
+            buffer->rewind_to_marker();
+            spdlog::error("ILP sink: rejected metric {} from {}/{}: {}", metric.name, msg.topic.node_id,
+                          msg.topic.device_id, err.what());
+            tables.erase(metric.name);
+        }
+    }
+}
+
+WriteResult IlpSink::write_batch(const std::vector<SinkMessagePtr>& batch) {
+    if (!ensure_sender()) {
+        return WriteResult::Retry;
+    }
+
+    buffer->clear();
+    for (const auto& msg : batch) {
+        // NBIRTH/NDEATH carry no time series here; tables are created by the first row
+        if (msg->topic.type == MessageType::DDATA || msg->topic.type == MessageType::NDATA) {
+            append_message(*msg);
+        }
+    }
+    if (buffer->row_count() == 0) {
+        return WriteResult::Ok;
+    }
+
+    // Rows QuestDB cannot take were already dropped above, so a failed flush is the connection
+    try {
+        sender->flush(*buffer);
+        return WriteResult::Ok;
+    } catch (const questdb::ingress::line_sender_error& err) {
+        spdlog::error("{} flush of {} rows failed: {}", sink_name, buffer->row_count(), err.what());
+        // A broken connection is replaced on the next attempt
+        buffer->clear();
+        return WriteResult::Retry;
+    }
+}
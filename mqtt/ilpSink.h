@@ -0,0 +1,48 @@
+#pragma once
+#include <questdb/ingress/line_sender.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "sink.h"
+
+/**
+ * Writes Sparkplug metrics straight to QuestDB over the InfluxDB Line Protocol.
+ * Uses the same table layout as FastAPI (one table per metric, node_name/device_name
+ * symbols, value or status column), so both paths can fill the same tables.
+ *
+ * The transport comes from the conf string: "tcp::addr=questdb:9009;..." or
+ * "http::addr=questdb:9000;...". Table names are validated once per metric and
+ * cached; each batch from the SinkRunner is appended to one buffer and flushed.
+ */
+class IlpSink : public Sink {
+public:
+    IlpSink(const std::string& sink_name, const std::string& conf);
+
+    std::string name() const override { return sink_name; }
+    WriteResult write_batch(const std::vector<SinkMessagePtr>& batch) override;
+
+private:
+    struct TableEntry {
+        std::unique_ptr<const std::string> metric_name;   // Owns the map key
+        std::string name;                                  // Owns the characters the view points at
+        std::optional<questdb::ingress::table_name_view> view;
+    };
+
+    const questdb::ingress::table_name_view& table_for(std::string_view metric_name);
+    void append_row(const questdb::ingress::table_name_view& table, const SparkplugTopic& topic,
+                    const DecodedMetric& metric);
+    void append_message(const DecodedMessage& msg);
+    bool ensure_sender();
+
+    std::string sink_name;
+    std::string conf;
+
+    std::optional<questdb::ingress::line_sender> sender;
+    std::optional<questdb::ingress::line_sender_buffer> buffer;   // Created from the first connected sender
+    std::unordered_map<std::string_view, TableEntry> tables;   // Keyed by metric name
+};
+
+// Same rule as sanitize_table_name() in fastapi/mainapi.py
+std::string sanitize_table_name(const std::string& metric_name);
@@ -0,0 +1,297 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * What push() does when the queue is full
+ */
+enum class OverflowPolicy {
+    Block,       // Wait until a worker frees a slot (no data loss, backs up the broker)
+    DropOldest,  // Discard the oldest queued item to make room
+    DropNewest   // Discard the item being pushed
+};
+
+inline OverflowPolicy overflow_policy_from_string(const std::string& name) {
+    if (name == "drop-oldest") return OverflowPolicy::DropOldest;
+    if (name == "drop-newest") return OverflowPolicy::DropNewest;
+    return OverflowPolicy::Block;
+}
+
+inline const char* overflow_policy_name(OverflowPolicy policy) {
+    switch (policy) {
+    case OverflowPolicy::DropOldest: return "drop-oldest";
+    case OverflowPolicy::DropNewest: return "drop-newest";
+    default: return "block";
+    }
+}
+
+struct QueueCounters {
+    std::atomic<uint64_t> enqueued{0};
+    std::atomic<uint64_t> dequeued{0};
+    std::atomic<uint64_t> dropped_oldest{0};
+    std::atomic<uint64_t> dropped_newest{0};
+    std::atomic<uint64_t> blocked{0};          // push() calls that had to wait for space
+    std::atomic<uint64_t> high_watermark{0};
+};
+
+/**
+ * Bounded lock-free queue (Vyukov ring buffer with per-cell sequence numbers).
+ * Any number of producers; consumers normally one per queue (the owning worker),
+ * but DropOldest lets a producer pop as well, which the algorithm allows.
+ * Capacity is rounded up to a power of two.
+ */
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue(size_t capacity, OverflowPolicy policy)
+        : policy(policy) {
+        size_t cap = 2;
+        while (cap < capacity) {
+            cap <<= 1;
+        }
+        mask = cap - 1;
+        cells.reset(new Cell[cap]);
+        for (size_t i = 0; i < cap; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    /**
+     * Enqueue according to the overflow policy.
+     * Returns false only when the item itself was dropped (DropNewest) or the queue was closed.
+     */
+    bool push(T item) {
+        if (try_push(item)) {
+            notify_consumer();
+            return true;
+        }
+
+        switch (policy) {
+        case OverflowPolicy::DropNewest:
+            counters.dropped_newest.fetch_add(1, std::memory_order_relaxed);
+            return false;
+
+        case OverflowPolicy::DropOldest: {
+            T discarded;
+            while (!try_push(item)) {
+                if (try_pop(discarded)) {
+                    counters.dropped_oldest.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            notify_consumer();
+            return true;
+        }
+
+        case OverflowPolicy::Block:
+        default:
+            counters.blocked.fetch_add(1, std::memory_order_relaxed);
+            while (!try_push(item)) {
+                if (closed.load(std::memory_order_acquire)) {
+                    return false;
+                }
+                std::unique_lock<std::mutex> lock(wait_mutex);
+                producers_waiting.fetch_add(1);
+                space_cv.wait_for(lock, std::chrono::milliseconds(10));
+                producers_waiting.fetch_sub(1);
+            }
+            notify_consumer();
+            return true;
+        }
+    }
+
+    bool try_pop(T& out) {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        out = std::move(cell->data);
+        cell->data = T();
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        counters.dequeued.fetch_add(1, std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (producers_waiting.load() > 0) {
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            space_cv.notify_one();
+        }
+        return true;
+    }
+
+    // Pop, sleeping up to `timeout` when the queue is empty
+    bool pop_wait(T& out, std::chrono::milliseconds timeout) {
+        if (try_pop(out)) {
+            return true;
+        }
+        std::unique_lock<std::mutex> lock(wait_mutex);
+        consumers_waiting.fetch_add(1);
+        bool got = try_pop(out);
+        if (!got && !closed.load(std::memory_order_acquire)) {
+            items_cv.wait_for(lock, timeout);
+        }
+        consumers_waiting.fetch_sub(1);
+        lock.unlock();
+        return got || try_pop(out);
+    }
+
+    void close() {
+        closed.store(true, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(wait_mutex);
+        items_cv.notify_all();
+        space_cv.notify_all();
+    }
+
+    size_t depth() const {
+        size_t head = dequeue_pos.load(std::memory_order_relaxed);
+        size_t tail = enqueue_pos.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const { return mask + 1; }
+    const QueueCounters& stats() const { return counters; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    bool try_push(T& item) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        counters.enqueued.fetch_add(1, std::memory_order_relaxed);
+        uint64_t depth_now = depth();
+        uint64_t high = counters.high_watermark.load(std::memory_order_relaxed);
+        while (depth_now > high &&
+               !counters.high_watermark.compare_exchange_weak(high, depth_now, std::memory_order_relaxed)) {
+        }
+        return true;
+    }
+
+    // Only touches the mutex when a worker is actually asleep
+    void notify_consumer() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (consumers_waiting.load() > 0) {
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            items_cv.notify_one();
+        }
+    }
+
+    OverflowPolicy policy;
+    size_t mask = 0;
+    std::unique_ptr<Cell[]> cells;
+
+    alignas(64) std::atomic<size_t> enqueue_pos{0};
+    alignas(64) std::atomic<size_t> dequeue_pos{0};
+    alignas(64) QueueCounters counters;
+
+    std::atomic<int> consumers_waiting{0};
+    std::atomic<int> producers_waiting{0};
+    std::atomic<bool> closed{false};
+    std::mutex wait_mutex;
+    std::condition_variable items_cv;
+    std::condition_variable space_cv;
+};
+
+/**
+ * Pool of worker threads, each draining its own MpscQueue.
+ * Items are sharded by a key (the Sparkplug group/node) so messages from one
+ * node are always handled in order by the same worker.
+ */
+template <typename T>
+class IngestWorkers {
+public:
+    using Handler = std::function<void(T&)>;
+
+    IngestWorkers(size_t workers, size_t capacity_per_worker, OverflowPolicy policy, Handler handler)
+        : handler(std::move(handler)) {
+        if (workers == 0) {
+            workers = 1;
+        }
+        for (size_t i = 0; i < workers; ++i) {
+            queues.emplace_back(new MpscQueue<T>(capacity_per_worker, policy));
+        }
+        for (size_t i = 0; i < workers; ++i) {
+            threads.emplace_back([this, i] { run(*queues[i]); });
+        }
+    }
+
+    ~IngestWorkers() { stop(); }
+
+    bool submit(size_t shard_hash, T item) {
+        return queues[shard_hash % queues.size()]->push(std::move(item));
+    }
+
+    // Drain what is queued, then join the workers
+    void stop() {
+        if (!running.exchange(false)) {
+            return;
+        }
+        for (auto& q : queues) {
+            q->close();
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+    size_t size() const { return queues.size(); }
+    const MpscQueue<T>& queue(size_t i) const { return *queues[i]; }
+    std::thread::native_handle_type native_handle(size_t i) { return threads[i].native_handle(); }
+
+private:
+    void run(MpscQueue<T>& q) {
+        T item;
+        while (running.load(std::memory_order_acquire) || q.depth() > 0) {
+            if (q.pop_wait(item, std::chrono::milliseconds(100))) {
+                handler(item);
+                item = T();
+            }
+        }
+    }
+
+    Handler handler;
+    std::atomic<bool> running{true};
+    std::vector<std::unique_ptr<MpscQueue<T>>> queues;
+    std::vector<std::thread> threads;
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * Collects latency samples for one reporting window and computes percentiles.
+ * Keeps at most max_samples per window (reservoir style overwrite once full).
+ */
+class LatencyStats {
+public:
+    struct Summary {
+        uint64_t count = 0;
+        double p50_ms = 0;
+        double p99_ms = 0;
+        double max_ms = 0;
+    };
+
+    explicit LatencyStats(size_t max_samples = 100000) : max_samples(max_samples) {
+        samples.reserve(std::min<size_t>(max_samples, 4096));
+    }
+
+    void record(std::chrono::steady_clock::duration latency) {
+        uint64_t us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (samples.size() < max_samples) {
+            samples.push_back(us);
+        } else {
+            samples[seen % max_samples] = us;
+        }
+        seen++;
+    }
+
+    // Percentiles of the current window, then start a new window
+    Summary take() {
+        std::vector<uint64_t> window;
+        uint64_t count;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            window.swap(samples);
+            count = seen;
+            seen = 0;
+        }
+        Summary summary;
+        summary.count = count;
+        if (window.empty()) {
+            return summary;
+        }
+        summary.p50_ms = percentile(window, 0.50) / 1000.0;
+        summary.p99_ms = percentile(window, 0.99) / 1000.0;
+        summary.max_ms = *std::max_element(window.begin(), window.end()) / 1000.0;
+        return summary;
+    }
+
+private:
+    static double percentile(std::vector<uint64_t>& values, double q) {
+        size_t idx = (size_t)(q * (values.size() - 1));
+        std::nth_element(values.begin(), values.begin() + idx, values.end());
+        return (double)values[idx];
+    }
+
+    size_t max_samples;
+    uint64_t seen = 0;
+    std::vector<uint64_t> samples;
+    std::mutex mutex;
+};
@@ -0,0 +1,163 @@
+#include "loadController.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include "metrics.h"
+#include "sink.h"
+#include "subscriberConfig.h"
+
+const char* load_level_name(LoadLevel level) {
+    switch (level) {
+    case LoadLevel::BigBatches: return "big-batches";
+    case LoadLevel::ChangesOnly: return "changes-only";
+    case LoadLevel::Shed: return "shed";
+    default: return "normal";
+    }
+}
+
+LoadControlOptions LoadControlOptions::from_env() {
+    LoadControlOptions o;
+    o.enabled = env_long("LOAD_CONTROL", o.enabled ? 1 : 0) != 0;
+    o.queue_high = std::clamp(env_long("LOAD_QUEUE_HIGH_PCT", (long)(o.queue_high * 100)), 1L, 100L) / 100.0;
+    o.latency_high = std::chrono::milliseconds(
+        std::max(1L, env_long("LOAD_LATENCY_HIGH_MS", (long)o.latency_high.count())));
+    o.batch_scale = (size_t)std::max(1L, env_long("LOAD_BATCH_SCALE", (long)o.batch_scale));
+    o.interval = std::chrono::milliseconds(std::max(50L, env_long("LOAD_INTERVAL_MS", (long)o.interval.count())));
+    o.hold = std::chrono::milliseconds(std::max(0L, env_long("LOAD_HOLD_MS", (long)o.hold.count())));
+    return o;
+}
+
+LoadController::LoadController(LoadControlOptions options) : options(options) {
+    healthy_since = std::chrono::steady_clock::now();
+}
+
+void LoadController::evaluate() {
+    if (!options.enabled) {
+        return;
+    }
+    std::vector<SinkLoad> loads;
+    for (SinkFanOut* fan_out : sinks) {
+        std::vector<SinkLoad> more = fan_out->loads();
+        loads.insert(loads.end(), more.begin(), more.end());
+    }
+
+    // Per sink: queue fill, spool fill and mean write time since the last look (from the /metrics histograms)
+    const double high_ms = (double)options.latency_high.count();
+    double fill = 0;
+    double latency_ms = 0;
+    bool overloaded = false;
+    bool healthy = true;
+    bool must_drop = false;    // A sink is behind and its spool cannot take the backlog
+    for (const SinkLoad& load : loads) {
+        std::pair<uint64_t, uint64_t>& last = last_write[load.name];
+        LatencyHistogram::Snapshot s = pipeline_metrics().sink(load.name).write.snapshot();
+        uint64_t count = s.count - last.first;
+        uint64_t sum_us = s.sum_us - last.second;
+        last = {s.count, s.sum_us};
+        double sink_ms = count > 0 ? sum_us / 1000.0 / count : 0;
+
+        bool spooled = load.spool_fill >= 0;
+        bool behind = load.queue_fill >= options.queue_high || sink_ms >= high_ms ||
+                      (spooled && load.spool_fill >= options.queue_high);
+        overloaded = overloaded || behind;
+        healthy = healthy && load.queue_fill < options.queue_high / 2 && sink_ms < high_ms / 2 &&
+                  (!spooled || load.spool_fill < options.queue_high / 2);
+        must_drop = must_drop || (behind && (!spooled || load.spool_fill >= options.queue_high));
+        fill = std::max(fill, load.queue_fill);
+        latency_ms = std::max(latency_ms, sink_ms);
+    }
+
+    // Dropping data is pointless while the spools absorb the backlog: it is replayed later anyway
+    const LoadLevel ceiling = must_drop ? LoadLevel::Shed : LoadLevel::BigBatches;
+    auto now = std::chrono::steady_clock::now();
+    LoadLevel level = current.load();
+
+    if (level > ceiling) {
+        set_level(ceiling);
+        spdlog::info("Sink spools absorb the backlog: load level {}", load_level_name(ceiling));
+        healthy_since = now;
+    } else if (overloaded && level < ceiling) {
+        set_level((LoadLevel)((int)level + 1));
+        spdlog::warn("Sinks falling behind (queue fill {:.0f}%, write latency {:.0f} ms): load level {}",
+                     fill * 100, latency_ms, load_level_name(current.load()));
+        healthy_since = now;
+    } else if (!healthy) {
+        healthy_since = now;
+    } else if (level != LoadLevel::Normal && now - healthy_since >= options.hold) {
+        set_level((LoadLevel)((int)level - 1));
+        spdlog::info("Sinks caught up: load level {}", load_level_name(current.load()));
+        healthy_since = now;
+    }
+}
+
+void LoadController::set_level(LoadLevel level) {
+    current.store(level, std::memory_order_relaxed);
+    size_t scale = level >= LoadLevel::BigBatches ? options.batch_scale : 1;
+    for (SinkFanOut* fan_out : sinks) {
+        fan_out->set_batch_scale(scale);
+    }
+    if (level < LoadLevel::ChangesOnly) {
+        std::lock_guard<std::mutex> lock(values_mutex);
+        last_values.clear();
+    }
+    pipeline_metrics().load_level.store((int)level, std::memory_order_relaxed);
+}
+
+bool LoadController::admit(const DecodedMessage& msg) {
+    LoadLevel level = current.load(std::memory_order_relaxed);
+    if (level < LoadLevel::ChangesOnly) {
+        return true;
+    }
+    MessageType type = msg.topic.type;
+    if (type != MessageType::DDATA && type != MessageType::NDATA) {
+        return true;   // Births, deaths and commands are never shed
+    }
+    PipelineMetrics::TypeCounters& counters = pipeline_metrics().type(type);
+    if (level == LoadLevel::Shed) {
+        counters.shed_priority.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (type == MessageType::DDATA && msg.ok && all_unchanged(msg)) {
+        counters.shed_unchanged.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool LoadController::all_unchanged(const DecodedMessage& msg) {
+    bool unchanged = true;
+    std::string key;
+    std::lock_guard<std::mutex> lock(values_mutex);
+    TopicValues& topic = last_values[std::string(msg.topic.topic)];
+    for (const DecodedMetric& metric : msg.metrics) {
+        if (!metric.has_value()) {
+            continue;
+        }
+        StoredValue value = std::visit([](const auto& v) -> StoredValue {
+            using V = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<V, std::string_view>) {
+                return std::string(v);
+            } else {
+                return v;
+            }
+        }, metric.value);
+        StoredValue* last;
+        if (metric.has_index()) {
+            if (metric.index >= topic.by_index.size()) {
+                topic.by_index.resize(metric.index + 1);
+            }
+            last = &topic.by_index[metric.index];
+        } else {
+            if (!metric.name.empty()) {
+                key.assign(metric.name);
+            } else {
+                key = '#' + std::to_string(metric.alias);
+            }
+            last = &topic.by_name[key];
+        }
+        if (*last != value) {
+            *last = std::move(value);
+            unchanged = false;
+        }
+    }
+    return unchanged && !msg.metrics.empty();
+}
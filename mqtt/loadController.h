@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+#include "decodedMessage.h"
+
+class SinkFanOut;
+
+/**
+ * Load levels, escalated one at a time while the sinks fall behind
+ */
+enum class LoadLevel {
+    Normal,          // Configured batch sizes
+    BigBatches,      // Batch limits multiplied by batch_scale: fewer, larger writes
+    ChangesOnly,     // + DDATA whose metric values are all unchanged is not forwarded
+    Shed             // + no DDATA/NDATA at all; NBIRTH/NDEATH (and NCMD/DCMD analysis) always pass
+};
+
+const char* load_level_name(LoadLevel level);
+
+/**
+ * Thresholds of the load controller, from LOAD_CONTROL (off unless 1), LOAD_QUEUE_HIGH_PCT
+ * (sink queue fill, and spool fill of SPOOL_MAX_BYTES), LOAD_LATENCY_HIGH_MS (mean sink write
+ * time), LOAD_BATCH_SCALE, LOAD_INTERVAL_MS and LOAD_HOLD_MS (how long the sinks must look
+ * healthy before stepping down).
+ */
+struct LoadControlOptions {
+    bool enabled = false;
+    double queue_high = 0.5;
+    std::chrono::milliseconds latency_high{1000};
+    size_t batch_scale = 4;
+    std::chrono::milliseconds interval{500};
+    std::chrono::milliseconds hold{5000};
+
+    static LoadControlOptions from_env();
+};
+
+/**
+ * Watches sink queue fill, spool fill and write latency and escalates through the LoadLevel
+ * steps when any is above its threshold; it steps down one level once all stayed below half
+ * the thresholds for `hold`. Levels that drop data are only reached when a sink that is behind
+ * has no spool, or its spool is past the threshold too: otherwise the spool takes the backlog
+ * and the controller stays at BigBatches. evaluate() is called every `interval` from the main loop.
+ * The ingest workers ask admit() before handing a message to the sinks; every message it
+ * refuses is counted per type in PipelineMetrics.
+ */
+class LoadController {
+public:
+    explicit LoadController(LoadControlOptions options);
+
+    LoadController(const LoadController&) = delete;
+    LoadController& operator=(const LoadController&) = delete;
+
+    // Watch (and scale the batches of) these sinks; call before messages flow
+    void add_sinks(SinkFanOut* fan_out) { sinks.push_back(fan_out); }
+
+    // false when the message should not go to the sinks at the current level
+    bool admit(const DecodedMessage& msg);
+
+    void evaluate();
+
+    LoadLevel level() const { return current.load(std::memory_order_relaxed); }
+    bool enabled() const { return options.enabled; }
+    std::chrono::milliseconds interval() const { return options.interval; }
+
+private:
+    using StoredValue = std::variant<std::monostate, bool, int64_t, uint64_t, double, std::string>;
+
+    void set_level(LoadLevel level);
+    bool all_unchanged(const DecodedMessage& msg);
+
+    LoadControlOptions options;
+    std::vector<SinkFanOut*> sinks;
+    std::atomic<LoadLevel> current{LoadLevel::Normal};
+    std::chrono::steady_clock::time_point healthy_since;
+    std::unordered_map<std::string, std::pair<uint64_t, uint64_t>> last_write;   // Per sink: count, sum_us
+
+    // Last forwarded values of one topic: by DecodedMetric::index, by name for unindexed metrics
+    struct TopicValues {
+        std::vector<StoredValue> by_index;      // monostate = not seen yet
+        std::unordered_map<std::string, StoredValue> by_name;
+    };
+
+    // Per topic, only kept while ChangesOnly or higher is active
+    std::mutex values_mutex;
+    std::unordered_map<std::string, TopicValues> last_values;
+};
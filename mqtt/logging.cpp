@@ -0,0 +1,46 @@
+#include "logging.h"
+#include <algorithm>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include "subscriberConfig.h"
+
+namespace {
+
+spdlog::level::level_enum level_from_env(const char* name, spdlog::level::level_enum fallback) {
+    std::string value = env_string(name, "");
+    if (value.empty()) {
+        return fallback;
+    }
+    spdlog::level::level_enum level = spdlog::level::from_str(value);
+    // from_str() maps anything unknown to "off"
+    return (level == spdlog::level::off && value != "off") ? fallback : level;
+}
+
+bool block_when_full = false;
+
+}  // namespace
+
+LogOptions LogOptions::from_env() {
+    LogOptions o;
+    o.level = level_from_env("LOG_LEVEL", o.level);
+    o.message_level = level_from_env("LOG_MESSAGE_LEVEL", o.message_level);
+    o.sample_every = (uint64_t)std::max(1L, env_long("LOG_SAMPLE_EVERY", (long)o.sample_every));
+    o.queue_size = (size_t)std::max(128L, env_long("LOG_QUEUE_SIZE", (long)o.queue_size));
+    o.block_when_full = env_string("LOG_OVERFLOW", "drop") == "block";
+    return o;
+}
+
+void init_async_logging(const LogOptions& options) {
+    block_when_full = options.block_when_full;
+    spdlog::init_thread_pool(options.queue_size, 1);
+    spdlog::set_level(options.level);
+    auto console = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+    spdlog::set_default_logger(make_async_logger("main", {console}));
+}
+
+std::shared_ptr<spdlog::logger> make_async_logger(const std::string& name, spdlog::sinks_init_list sinks) {
+    auto policy = block_when_full ? spdlog::async_overflow_policy::block
+                                  : spdlog::async_overflow_policy::overrun_oldest;
+    auto logger = std::make_shared<spdlog::async_logger>(name, sinks, spdlog::thread_pool(), policy);
+    logger->set_level(spdlog::get_level());
+    return logger;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <spdlog/spdlog.h>
+#include <spdlog/async.h>
+
+/**
+ * Logging setup for paho-sub. Every logger is an spdlog async logger on one shared thread
+ * pool with a bounded queue, so the ingest threads only format and enqueue a line.
+ * With overflow "drop" (the default) a full queue overwrites the oldest lines instead of
+ * blocking ingest; "block" keeps every line at the cost of stalling behind slow output.
+ */
+struct LogOptions {
+    spdlog::level::level_enum level = spdlog::level::info;            // LOG_LEVEL
+    spdlog::level::level_enum message_level = spdlog::level::debug;   // LOG_MESSAGE_LEVEL, per-message lines
+    uint64_t sample_every = 1;                                        // LOG_SAMPLE_EVERY, log 1 of N messages
+    size_t queue_size = 8192;                                         // LOG_QUEUE_SIZE (lines)
+    bool block_when_full = false;                                     // LOG_OVERFLOW: drop | block
+
+    static LogOptions from_env();
+};
+
+// Start the async thread pool and make the default logger async; call before any logger is made
+void init_async_logging(const LogOptions& options);
+
+std::shared_ptr<spdlog::logger> make_async_logger(const std::string& name, spdlog::sinks_init_list sinks);
+
+/**
+ * Gate for the per-message lines: enabled at LOG_MESSAGE_LEVEL and then every
+ * LOG_SAMPLE_EVERY-th message. One relaxed counter increment when enabled, a level compare otherwise.
+ */
+class MessageLogSampler {
+public:
+    explicit MessageLogSampler(const LogOptions& options)
+        : level(options.message_level), every(options.sample_every ? options.sample_every : 1) {}
+
+    bool should_log() {
+        if (!spdlog::default_logger_raw()->should_log(level)) {
+            return false;
+        }
+        return every == 1 || seen.fetch_add(1, std::memory_order_relaxed) % every == 0;
+    }
+
+    spdlog::level::level_enum log_level() const { return level; }
+
+private:
+    spdlog::level::level_enum level;
+    uint64_t every;
+    std::atomic<uint64_t> seen{0};
+};
@@ -0,0 +1,140 @@
+#include "metricAliasTable.h"
+#include <algorithm>
+#include <functional>
+#include "metrics.h"
+
+uint32_t MetricAliasTable::slot_for(NodeTable& node, std::string& name_key, size_t prefix,
+                                    const DecodedMetric& metric) {
+    name_key.resize(prefix);
+    name_key.append(metric.name);
+    auto it = node.by_name.find(name_key);
+    if (it != node.by_name.end()) {
+        return it->second;
+    }
+    if (node.slots.size() >= MAX_SLOTS) {
+        return DecodedMetric::NO_INDEX;
+    }
+    uint32_t slot = (uint32_t)node.slots.size();
+    node.slots.push_back(Slot{std::string(metric.name), std::string(metric.data_type)});
+    node.by_name.emplace(name_key, slot);
+    return slot;
+}
+
+void MetricAliasTable::bind(NodeTable& node, uint64_t alias, uint32_t slot) {
+    if (alias < DENSE_ALIASES) {
+        if (alias >= node.by_alias.size()) {
+            node.by_alias.resize(alias + 1, DecodedMetric::NO_INDEX);
+        }
+        node.by_alias[alias] = slot;
+        return;
+    }
+    auto it = std::lower_bound(node.sparse_aliases.begin(), node.sparse_aliases.end(),
+                               std::make_pair(alias, (uint32_t)0));
+    if (it != node.sparse_aliases.end() && it->first == alias) {
+        it->second = slot;
+    } else {
+        node.sparse_aliases.insert(it, {alias, slot});
+    }
+}
+
+uint32_t MetricAliasTable::lookup(const NodeTable& node, uint64_t alias) {
+    if (alias < node.by_alias.size()) {
+        return node.by_alias[alias];
+    }
+    auto it = std::lower_bound(node.sparse_aliases.begin(), node.sparse_aliases.end(),
+                               std::make_pair(alias, (uint32_t)0));
+    if (it != node.sparse_aliases.end() && it->first == alias) {
+        return it->second;
+    }
+    return DecodedMetric::NO_INDEX;
+}
+
+std::shared_ptr<const void> MetricAliasTable::resolve(const SparkplugTopic& topic,
+                                                      std::vector<DecodedMetric>& metrics, bool& named) {
+    named = false;
+    const MessageType type = topic.type;
+    const bool birth = type == MessageType::NBIRTH || type == MessageType::DBIRTH;
+    if (!birth && type != MessageType::DDATA && type != MessageType::NDATA) {
+        return nullptr;
+    }
+
+    std::string key;
+    key.reserve(topic.group_id.size() + topic.node_id.size() + 1);
+    key.append(topic.group_id);
+    key += '/';
+    key.append(topic.node_id);
+    Stripe& stripe = stripes[std::hash<std::string>{}(key) % STRIPES];
+
+    // "device|" prefix of the name keys; node metrics have an empty device
+    std::string name_key;
+    name_key.reserve(topic.device_id.size() + 64);
+    name_key.append(topic.device_id);
+    name_key += '|';
+    const size_t prefix = name_key.size();
+
+    uint64_t resolved = 0;
+    uint64_t unresolved = 0;
+    std::shared_ptr<NodeTable> node;
+    {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        std::shared_ptr<NodeTable>& entry = stripe.nodes[key];
+        if (!entry) {
+            entry = std::make_shared<NodeTable>();
+        }
+        node = entry;
+        if (type == MessageType::NBIRTH) {
+            node->by_alias.clear();
+            node->sparse_aliases.clear();
+        }
+
+        for (DecodedMetric& metric : metrics) {
+            if (birth) {
+                if (metric.name.empty()) {
+                    continue;
+                }
+                metric.index = slot_for(*node, name_key, prefix, metric);
+                if (metric.has_alias && metric.index != DecodedMetric::NO_INDEX) {
+                    bind(*node, metric.alias, metric.index);
+                }
+                continue;
+            }
+            if (metric.has_alias) {
+                uint32_t slot = lookup(*node, metric.alias);
+                if (slot != DecodedMetric::NO_INDEX) {
+                    metric.index = slot;
+                    if (metric.name.empty()) {
+                        const Slot& bound = node->slots[slot];
+                        metric.name = bound.name;
+                        if (metric.data_type.empty()) {
+                            metric.data_type = bound.data_type;
+                        }
+                        named = true;
+                    }
+                    resolved++;
+                    continue;
+                }
+                if (metric.name.empty()) {
+                    unresolved++;   // Alias from a birth this process has not seen
+                    continue;
+                }
+            }
+            if (!metric.name.empty()) {
+                metric.index = slot_for(*node, name_key, prefix, metric);
+            }
+        }
+    }
+
+    PipelineMetrics::AliasCounters& counters = pipeline_metrics().aliases;
+    counters.resolved.fetch_add(resolved, std::memory_order_relaxed);
+    counters.unresolved.fetch_add(unresolved, std::memory_order_relaxed);
+    return node;
+}
+
+size_t MetricAliasTable::nodes() const {
+    size_t count = 0;
+    for (const Stripe& stripe : stripes) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        count += stripe.nodes.size();
+    }
+    return count;
+}
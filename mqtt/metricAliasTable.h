@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "decodedMessage.h"
+
+/**
+ * Per edge node metric table built from the births, so the rest of the pipeline can index
+ * metrics by a small integer instead of hashing their names.
+ *
+ * Every (device, metric name) of a node gets a slot the first time it is seen, numbered from 0
+ * and never reused, so a slot keeps meaning the same metric across rebirths. NBIRTH/DBIRTH
+ * also bind each metric's Sparkplug alias to its slot; NBIRTH drops the previous bindings.
+ * A DDATA/NDATA metric carrying a bound alias is resolved through a flat vector indexed by
+ * the alias, with no string hashing, and gets its name (and data type when it was left out)
+ * from the table, so alias only payloads work end to end. Named metrics without an alias
+ * cost one hash, once for the whole pipeline.
+ *
+ * One hash lookup per message finds the node, in lock striped tables like SequenceTracker.
+ */
+class MetricAliasTable {
+public:
+    MetricAliasTable() = default;
+
+    MetricAliasTable(const MetricAliasTable&) = delete;
+    MetricAliasTable& operator=(const MetricAliasTable&) = delete;
+
+    /**
+     * Set DecodedMetric::index of every metric and fill in the names of alias only metrics.
+     * `named` tells whether any name was filled in. The result keeps the table's name strings
+     * alive for the metric views pointing at them.
+     */
+    std::shared_ptr<const void> resolve(const SparkplugTopic& topic, std::vector<DecodedMetric>& metrics,
+                                        bool& named);
+
+    size_t nodes() const;
+
+private:
+    // Names are only ever appended (the deque never moves them), so views into them stay valid
+    struct Slot {
+        std::string name;
+        std::string data_type;
+    };
+
+    struct NodeTable {
+        std::deque<Slot> slots;
+        std::unordered_map<std::string, uint32_t> by_name;          // "device|name" -> slot
+        std::vector<uint32_t> by_alias;                             // alias -> slot, NO_INDEX when unbound
+        std::vector<std::pair<uint64_t, uint32_t>> sparse_aliases;  // Sorted, aliases beyond the dense range
+    };
+
+    struct Stripe {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<NodeTable>> nodes;
+    };
+
+    static constexpr size_t STRIPES = 16;
+    static constexpr uint64_t DENSE_ALIASES = 65536;    // Aliases below this index by_alias directly
+    static constexpr size_t MAX_SLOTS = 1 << 20;        // Per node; further metrics stay unindexed
+
+    static uint32_t slot_for(NodeTable& node, std::string& name_key, size_t prefix, const DecodedMetric& metric);
+    static void bind(NodeTable& node, uint64_t alias, uint32_t slot);
+    static uint32_t lookup(const NodeTable& node, uint64_t alias);
+
+    std::array<Stripe, STRIPES> stripes;
+};
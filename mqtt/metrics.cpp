@@ -0,0 +1,181 @@
+#include "metrics.h"
+#include <cstdio>
+
+namespace {
+
+// Bucket bounds exported to Prometheus, in microseconds (100 us .. 30 s)
+const uint64_t EXPORT_BOUNDS_US[] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000,
+    250000, 500000, 1000000, 2500000, 5000000, 10000000, 30000000,
+};
+
+std::string seconds(uint64_t us) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%g", us / 1e6);
+    return buf;
+}
+
+void counter(std::string& out, const char* name, const std::string& labels, uint64_t value) {
+    out += name;
+    out += '{';
+    out += labels;
+    out += "} ";
+    out += std::to_string(value);
+    out += '\n';
+}
+
+}  // namespace
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot s;
+    for (const Shard& shard : shards) {
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            s.counts[i] += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+        s.count += shard.count.load(std::memory_order_relaxed);
+        s.sum_us += shard.sum_us.load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+void render_histogram(std::string& out, const std::string& name, const std::string& labels,
+                      const LatencyHistogram& histogram) {
+    LatencyHistogram::Snapshot s = histogram.snapshot();
+    std::string sep = labels.empty() ? "" : ",";
+    // A bucket counts below a bound once its whole range is (values are whole microseconds)
+    size_t bucket = 0;
+    uint64_t cumulative = 0;
+    for (uint64_t bound : EXPORT_BOUNDS_US) {
+        while (bucket < LatencyHistogram::BUCKETS && LatencyHistogram::bucket_upper_us(bucket) <= bound + 1) {
+            cumulative += s.counts[bucket++];
+        }
+        out += name + "_bucket{" + labels + sep + "le=\"" + seconds(bound) + "\"} " + std::to_string(cumulative) + "\n";
+    }
+    out += name + "_bucket{" + labels + sep + "le=\"+Inf\"} " + std::to_string(s.count) + "\n";
+    out += name + "_sum{" + labels + "} " + seconds(s.sum_us) + "\n";
+    out += name + "_count{" + labels + "} " + std::to_string(s.count) + "\n";
+}
+
+PipelineMetrics::SinkMetrics& PipelineMetrics::sink(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& slot = sinks[name];
+    if (!slot) {
+        slot = std::make_unique<SinkMetrics>();
+    }
+    return *slot;
+}
+
+void PipelineMetrics::add_collector(Collector collector) {
+    std::lock_guard<std::mutex> lock(mutex);
+    collectors.push_back(std::move(collector));
+}
+
+std::string PipelineMetrics::render() {
+    std::string out;
+    out.reserve(16 * 1024);
+
+    out += "# TYPE paho_sub_messages_total counter\n";
+    for (size_t t = 0; t < types.size(); ++t) {
+        std::string labels = std::string("type=\"") + message_type_name((MessageType)t) + "\"";
+        counter(out, "paho_sub_messages_total", labels, types[t].messages.load(std::memory_order_relaxed));
+    }
+    out += "# TYPE paho_sub_bytes_total counter\n";
+    for (size_t t = 0; t < types.size(); ++t) {
+        std::string labels = std::string("type=\"") + message_type_name((MessageType)t) + "\"";
+        counter(out, "paho_sub_bytes_total", labels, types[t].bytes.load(std::memory_order_relaxed));
+    }
+    out += "# TYPE paho_sub_decode_errors_total counter\n";
+    for (size_t t = 0; t < types.size(); ++t) {
+        std::string labels = std::string("type=\"") + message_type_name((MessageType)t) + "\"";
+        counter(out, "paho_sub_decode_errors_total", labels, types[t].errors.load(std::memory_order_relaxed));
+    }
+
+    out += "# TYPE paho_sub_shed_total counter\n";
+    for (size_t t = 0; t < types.size(); ++t) {
+        std::string labels = std::string("type=\"") + message_type_name((MessageType)t) + "\"";
+        counter(out, "paho_sub_shed_total", labels + ",reason=\"unchanged\"",
+                types[t].shed_unchanged.load(std::memory_order_relaxed));
+        counter(out, "paho_sub_shed_total", labels + ",reason=\"priority\"",
+                types[t].shed_priority.load(std::memory_order_relaxed));
+    }
+    out += "# TYPE paho_sub_load_level gauge\n";
+    out += "paho_sub_load_level " + std::to_string(load_level.load(std::memory_order_relaxed)) + "\n";
+
+    out += "# TYPE paho_sub_seq_events_total counter\n";
+    counter(out, "paho_sub_seq_events_total", "kind=\"gap\"", sequence.gaps.load(std::memory_order_relaxed));
+    counter(out, "paho_sub_seq_events_total", "kind=\"late\"", sequence.late.load(std::memory_order_relaxed));
+    counter(out, "paho_sub_seq_events_total", "kind=\"duplicate\"", sequence.duplicates.load(std::memory_order_relaxed));
+    counter(out, "paho_sub_seq_events_total", "kind=\"out_of_window\"",
+            sequence.out_of_window.load(std::memory_order_relaxed));
+    counter(out, "paho_sub_seq_events_total", "kind=\"no_birth\"", sequence.no_birth.load(std::memory_order_relaxed));
+    counter(out, "paho_sub_seq_events_total", "kind=\"bdseq_mismatch\"",
+            sequence.bd_seq_mismatch.load(std::memory_order_relaxed));
+    out += "# TYPE paho_sub_seq_missing gauge\n";
+    out += "paho_sub_seq_missing " + std::to_string(sequence.missing.load(std::memory_order_relaxed)) + "\n";
+
+    out += "# TYPE paho_sub_deadband_metrics_total counter\n";
+    counter(out, "paho_sub_deadband_metrics_total", "result=\"forwarded\"",
+            deadband.forwarded.load(std::memory_order_relaxed));
+    counter(out, "paho_sub_deadband_metrics_total", "result=\"suppressed\"",
+            deadband.suppressed.load(std::memory_order_relaxed));
+    counter(out, "paho_sub_deadband_metrics_total", "result=\"heartbeat\"",
+            deadband.heartbeats.load(std::memory_order_relaxed));
+    out += "# TYPE paho_sub_deadband_messages_dropped_total counter\n";
+    out += "paho_sub_deadband_messages_dropped_total " +
+           std::to_string(deadband.messages_dropped.load(std::memory_order_relaxed)) + "\n";
+
+    out += "# TYPE paho_sub_rollup_samples_total counter\n";
+    out += "paho_sub_rollup_samples_total " + std::to_string(rollup.samples.load(std::memory_order_relaxed)) + "\n";
+    out += "# TYPE paho_sub_rollup_late_total counter\n";
+    out += "paho_sub_rollup_late_total " + std::to_string(rollup.late.load(std::memory_order_relaxed)) + "\n";
+    out += "# TYPE paho_sub_rollup_rows_total counter\n";
+    counter(out, "paho_sub_rollup_rows_total", "result=\"written\"",
+            rollup.rows_written.load(std::memory_order_relaxed));
+    counter(out, "paho_sub_rollup_rows_total", "result=\"dropped\"",
+            rollup.rows_dropped.load(std::memory_order_relaxed));
+
+    out += "# TYPE paho_sub_alias_metrics_total counter\n";
+    counter(out, "paho_sub_alias_metrics_total", "result=\"resolved\"",
+            aliases.resolved.load(std::memory_order_relaxed));
+    counter(out, "paho_sub_alias_metrics_total", "result=\"unresolved\"",
+            aliases.unresolved.load(std::memory_order_relaxed));
+
+    out += "# TYPE paho_sub_stage_seconds histogram\n";
+    render_histogram(out, "paho_sub_stage_seconds", "stage=\"queue_wait\"", queue_wait);
+    render_histogram(out, "paho_sub_stage_seconds", "stage=\"decode\"", decode);
+    render_histogram(out, "paho_sub_stage_seconds", "stage=\"analysis\"", analysis);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    out += "# TYPE paho_sub_sink_write_seconds histogram\n";
+    for (const auto& entry : sinks) {
+        render_histogram(out, "paho_sub_sink_write_seconds", "sink=\"" + entry.first + "\"", entry.second->write);
+    }
+    out += "# TYPE paho_sub_sink_latency_seconds histogram\n";
+    for (const auto& entry : sinks) {
+        render_histogram(out, "paho_sub_sink_latency_seconds", "sink=\"" + entry.first + "\"",
+                         entry.second->end_to_end);
+    }
+    out += "# TYPE paho_sub_sink_delivered_total counter\n";
+    for (const auto& entry : sinks) {
+        counter(out, "paho_sub_sink_delivered_total", "sink=\"" + entry.first + "\"", entry.second->delivered.load());
+    }
+    out += "# TYPE paho_sub_sink_failed_total counter\n";
+    for (const auto& entry : sinks) {
+        counter(out, "paho_sub_sink_failed_total", "sink=\"" + entry.first + "\"", entry.second->failed.load());
+    }
+    out += "# TYPE paho_sub_sink_dead_lettered_total counter\n";
+    for (const auto& entry : sinks) {
+        counter(out, "paho_sub_sink_dead_lettered_total", "sink=\"" + entry.first + "\"",
+                entry.second->dead_lettered.load());
+    }
+
+    for (const auto& collect : collectors) {
+        collect(out);
+    }
+    return out;
+}
+
+PipelineMetrics& pipeline_metrics() {
+    static PipelineMetrics metrics;
+    return metrics;
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "sparkplugTopic.h"
+
+/**
+ * Log-linear (HDR style) histogram of microsecond values: exact below 16 us, then 8 buckets per
+ * power of two, so any value is within 12.5% of its bucket. record() is a relaxed atomic add in
+ * the calling thread's own shard, so ingest and sink threads never share a cache line;
+ * snapshot() sums the shards when /metrics is scraped.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t BUCKETS = 16 + 36 * 8;   // Up to ~2^40 us (12 days)
+
+    struct Snapshot {
+        std::array<uint64_t, BUCKETS> counts{};
+        uint64_t count = 0;
+        uint64_t sum_us = 0;
+    };
+
+    void record(uint64_t us) {
+        Shard& shard = shards[thread_shard()];
+        shard.buckets[bucket_index(us)].fetch_add(1, std::memory_order_relaxed);
+        shard.count.fetch_add(1, std::memory_order_relaxed);
+        shard.sum_us.fetch_add(us, std::memory_order_relaxed);
+    }
+
+    void record(std::chrono::steady_clock::duration elapsed) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        record(us > 0 ? (uint64_t)us : 0);
+    }
+
+    Snapshot snapshot() const;
+
+    static size_t bucket_index(uint64_t us) {
+        if (us < 16) {
+            return (size_t)us;
+        }
+        unsigned exponent = 63 - (unsigned)__builtin_clzll(us);
+        size_t index = 16 + (exponent - 4) * 8 + ((us >> (exponent - 3)) & 7);
+        return index < BUCKETS ? index : BUCKETS - 1;
+    }
+
+    // Exclusive upper bound of a bucket
+    static uint64_t bucket_upper_us(size_t index) {
+        if (index < 16) {
+            return index + 1;
+        }
+        unsigned exponent = (unsigned)((index - 16) / 8) + 4;
+        return (uint64_t)(9 + (index - 16) % 8) << (exponent - 3);
+    }
+
+private:
+    static constexpr size_t SHARDS = 8;
+
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum_us{0};
+    };
+
+    // Threads get shards round robin in the order they first record
+    static size_t thread_shard() {
+        static std::atomic<size_t> next{0};
+        thread_local size_t shard = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return shard;
+    }
+
+    std::array<Shard, SHARDS> shards;
+};
+
+/**
+ * Counters and latency histograms of the subscriber pipeline, rendered in the Prometheus
+ * text format by MetricsServer:
+ *   arrival -> queue_wait -> decode -> analysis, then per sink the write_batch() time and
+ *   arrival to delivered, plus messages/bytes/decode errors per Sparkplug message type.
+ * Queue depths and other state owned elsewhere are added as collectors, called on scrape.
+ */
+class PipelineMetrics {
+public:
+    struct TypeCounters {
+        std::atomic<uint64_t> messages{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> shed_unchanged{0};   // Not forwarded by the load controller: no value changed
+        std::atomic<uint64_t> shed_priority{0};    // Not forwarded by the load controller: low priority
+    };
+
+    // Sparkplug seq checks per edge node, see SequenceTracker
+    struct SequenceCounters {
+        std::atomic<uint64_t> gaps{0};            // Messages that skipped ahead of the next seq
+        std::atomic<int64_t> missing{0};          // Seqs skipped over and not (yet) arrived late
+        std::atomic<uint64_t> late{0};            // Arrived behind the highest seq, filling a gap
+        std::atomic<uint64_t> duplicates{0};      // Dropped before analysis and the sinks
+        std::atomic<uint64_t> out_of_window{0};
+        std::atomic<uint64_t> no_birth{0};        // Data from a node without a seen NBIRTH
+        std::atomic<uint64_t> bd_seq_mismatch{0}; // NDEATH bdSeq other than the current birth's
+    };
+
+    struct DeadbandCounters {
+        std::atomic<uint64_t> forwarded{0};       // DDATA/NDATA metrics that passed their deadband
+        std::atomic<uint64_t> suppressed{0};      // Metrics within their deadband, not forwarded
+        std::atomic<uint64_t> heartbeats{0};      // Forwarded unchanged after max_silence
+        std::atomic<uint64_t> messages_dropped{0}; // Messages left without any metric
+    };
+
+    struct RollupCounters {
+        std::atomic<uint64_t> samples{0};         // Numeric samples added to the 1s/1m/1h buckets
+        std::atomic<uint64_t> late{0};            // Behind an already written bucket, left out of it
+        std::atomic<uint64_t> rows_written{0};    // Closed buckets accepted by FastAPI
+        std::atomic<uint64_t> rows_dropped{0};    // Beyond ROLLUP_MAX_PENDING_ROWS while FastAPI was down
+    };
+
+    struct AliasCounters {
+        std::atomic<uint64_t> resolved{0};        // DDATA/NDATA metrics resolved through their alias
+        std::atomic<uint64_t> unresolved{0};      // Alias only metrics of a birth not seen, left nameless
+    };
+
+    struct SinkMetrics {
+        LatencyHistogram write;               // One write_batch() call, e.g. the FastAPI round trip
+        LatencyHistogram end_to_end;          // MQTT arrival to accepted by the sink
+        std::atomic<uint64_t> delivered{0};
+        std::atomic<uint64_t> failed{0};
+        std::atomic<uint64_t> dead_lettered{0};  // Given up on for good, see SinkRunner::dead_letter()
+    };
+
+    // Appends its own lines (with # TYPE headers) to the scrape
+    using Collector = std::function<void(std::string& out)>;
+
+    LatencyHistogram queue_wait;
+    LatencyHistogram decode;
+    LatencyHistogram analysis;
+    std::atomic<int> load_level{0};           // LoadLevel of the load controller
+    SequenceCounters sequence;
+    DeadbandCounters deadband;
+    RollupCounters rollup;
+    AliasCounters aliases;
+
+    TypeCounters& type(MessageType t) { return types[(size_t)t]; }
+
+    // Created once per sink name and shared by every runner of that name
+    SinkMetrics& sink(const std::string& name);
+
+    void add_collector(Collector collector);
+
+    std::string render();
+
+private:
+    std::array<TypeCounters, (size_t)MessageType::Unknown + 1> types;
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<SinkMetrics>> sinks;
+    std::vector<Collector> collectors;
+};
+
+// The process wide instance
+PipelineMetrics& pipeline_metrics();
+
+// Prometheus histogram lines for one labelled series, in seconds
+void render_histogram(std::string& out, const std::string& name, const std::string& labels,
+                      const LatencyHistogram& histogram);
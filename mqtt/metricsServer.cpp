@@ -0,0 +1,99 @@
+#include "metricsServer.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+MetricsServer::MetricsServer(const std::string& bind_address, int port, std::function<std::string()> render)
+    : render(std::move(render)) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (::inet_pton(AF_INET, bind_address.c_str(), &addr.sin_addr) != 1) {
+        spdlog::error("Metrics endpoint: '{}' is not an IPv4 address, not listening", bind_address);
+        return;
+    }
+
+    listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        spdlog::error("Metrics endpoint: socket() failed: {}", std::strerror(errno));
+        return;
+    }
+    int one = 1;
+    ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if (::bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(listen_fd, 16) != 0) {
+        spdlog::error("Metrics endpoint: cannot listen on {}:{}: {}", bind_address, port, std::strerror(errno));
+        ::close(listen_fd);
+        listen_fd = -1;
+        return;
+    }
+    spdlog::info("Metrics endpoint on http://{}:{}/metrics", bind_address, port);
+    acceptor = std::thread([this] { accept_loop(); });
+}
+
+MetricsServer::~MetricsServer() {
+    running = false;
+    if (listen_fd >= 0) {
+        ::shutdown(listen_fd, SHUT_RDWR);
+        ::close(listen_fd);
+    }
+    if (acceptor.joinable()) {
+        acceptor.join();
+    }
+}
+
+void MetricsServer::accept_loop() {
+    while (running.load()) {
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (!running.load()) {
+                return;
+            }
+            continue;
+        }
+        handle(fd);
+        ::close(fd);
+    }
+}
+
+void MetricsServer::handle(int fd) {
+    // A stuck client must not hold up the next scrape for long
+    timeval timeout{2, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char buf[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            break;
+        }
+        request.append(buf, (size_t)n);
+    }
+
+    std::string body;
+    std::string status = "404 Not Found";
+    std::string type = "text/plain";
+    if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 13, "GET /metrics?") == 0) {
+        body = render();
+        status = "200 OK";
+        type = "text/plain; version=0.0.4";
+    }
+    std::string response = "HTTP/1.0 " + status + "\r\nContent-Type: " + type +
+                           "\r\nContent-Length: " + std::to_string(body.size()) +
+                           "\r\nConnection: close\r\n\r\n" + body;
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = ::send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return;
+        }
+        sent += (size_t)n;
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+/**
+ * Minimal HTTP/1.0 server for Prometheus scrapes: answers GET /metrics with the text from
+ * `render` and anything else with 404, one connection at a time on its own thread.
+ * Scrapes are rare, so there is no keep-alive and no thread per client.
+ * Listens on one IPv4 address only (loopback unless told otherwise), there is no auth.
+ */
+class MetricsServer {
+public:
+    MetricsServer(const std::string& bind_address, int port, std::function<std::string()> render);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    bool listening() const { return listen_fd >= 0; }
+
+private:
+    void accept_loop();
+    void handle(int fd);
+
+    std::function<std::string()> render;
+    int listen_fd = -1;
+    std::atomic<bool> running{true};
+    std::thread acceptor;
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <mqtt/properties.h>
+
+/**
+ * MQTT v5 user property stamped on every message by paho-pub: the publish time in
+ * microseconds since the epoch, so paho-sub can measure publisher to subscriber latency.
+ * Both ends use the system clock, so across hosts the numbers are only as good as NTP.
+ */
+constexpr const char* PUBLISH_TS_PROPERTY = "pub_ts_us";
+
+inline int64_t epoch_us_now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+inline mqtt::property publish_ts_property() {
+    return mqtt::property(mqtt::property::USER_PROPERTY, PUBLISH_TS_PROPERTY, std::to_string(epoch_us_now()));
+}
+
+// The publish timestamp carried by a message, or 0 when it has none (v3.1.1 or another publisher)
+inline int64_t publish_ts_us(const mqtt::properties& props) {
+    size_t n = props.count(mqtt::property::USER_PROPERTY);
+    for (size_t i = 0; i < n; ++i) {
+        auto kv = mqtt::get<mqtt::string_pair>(props, mqtt::property::USER_PROPERTY, i);
+        if (std::get<0>(kv) == PUBLISH_TS_PROPERTY) {
+            return std::strtoll(std::get<1>(kv).c_str(), nullptr, 10);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,433 @@
+/**
+ * @file
+ * @brief Sparkplug B load generator: many simulated edge nodes publishing NBIRTH -> DBIRTH -> DDATA
+ *
+ *   paho-load [--nodes <n>] [--devices <per node>] [--metrics <per device>] [--rate <DDATA/s per device>]
+ *             [--threads <n>] [--duration <s>] [--qos <0|1>] [--inflight <n>] [--group <group_id>]
+ *             [--encoding json|pretty|cbor|msgpack]
+ *
+ * Nodes are split over --threads connections. Each thread births its nodes and devices, then
+ * sends DDATA round robin over its devices at --rate messages per second per device (0 = as
+ * fast as it can), every metric a random walk, with seq running 0-255 per node like a real
+ * edge node. Publishes are pipelined: up to --inflight per connection are outstanding, and the
+ * time from publish to its completion (the PUBACK with QoS 1, written to the socket with QoS 0)
+ * is the ack latency reported every 5 s next to the achieved publish rate. On exit each node
+ * sends its NDEATH. The broker is MQTT_SERVER (default tcp://localhost:1883); MQTT_VERSION=5
+ * adds the publish timestamp property, so paho-sub reports publish to arrival latency too.
+ * Payloads are compact JSON unless --encoding (or PAYLOAD_ENCODING) says otherwise.
+ */
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <csignal>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+#include <mqtt/async_client.h>
+#include "latencyStats.h"
+#include "mqttTrace.h"
+#include "payloadEncoding.h"
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+std::atomic<bool> stop_requested{false};
+
+void on_signal(int) {
+    stop_requested = true;
+}
+
+struct LoadOptions {
+    std::string server = "tcp://localhost:1883";
+    std::string group = "LoadTest";
+    size_t nodes = 100;
+    size_t devices = 10;        // Per node
+    size_t metrics = 10;        // Per device
+    double rate = 1.0;          // DDATA per second per device, 0 = unthrottled
+    size_t threads = 0;         // 0 = one per core, at most one per node
+    double duration_s = 0;      // 0 = until Ctrl+C
+    int qos = 0;
+    size_t inflight = 1000;     // Outstanding publishes per connection
+    PayloadEncoding encoding = PayloadEncoding::Json;
+    bool v5 = false;
+};
+
+void usage() {
+    std::cerr << "usage: paho-load [--nodes <n>] [--devices <per node>] [--metrics <per device>] "
+                 "[--rate <DDATA/s per device>]\n"
+              << "                 [--threads <n>] [--duration <s>] [--qos <0|1>] [--inflight <n>] "
+                 "[--group <group_id>]\n"
+              << "                 [--encoding json|pretty|cbor|msgpack]\n";
+}
+
+// Publish and completion counters shared by every thread
+struct LoadStats {
+    std::atomic<uint64_t> published{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> late{0};          // Times a thread fell more than a second behind its schedule
+    LatencyStats ack_latency;
+};
+
+uint64_t steady_us() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Completion of the pipelined publishes of one connection. The publish time travels in the
+ * token's user context, so nothing is allocated or looked up per message.
+ */
+class InflightWindow : public virtual mqtt::iaction_listener {
+public:
+    explicit InflightWindow(LoadStats& stats) : stats(stats) {}
+
+    void on_success(const mqtt::token& tok) override {
+        uint64_t sent_us = (uint64_t)(uintptr_t)tok.get_user_context();
+        stats.ack_latency.record(std::chrono::microseconds(steady_us() - sent_us));
+        stats.completed.fetch_add(1, std::memory_order_relaxed);
+        outstanding.fetch_sub(1, std::memory_order_release);
+    }
+
+    void on_failure(const mqtt::token&) override {
+        stats.failed.fetch_add(1, std::memory_order_relaxed);
+        outstanding.fetch_sub(1, std::memory_order_release);
+    }
+
+    // Blocks while the window is full
+    void acquire(size_t limit) {
+        while (outstanding.load(std::memory_order_acquire) >= limit) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        outstanding.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void drain(std::chrono::seconds timeout) {
+        auto deadline = Clock::now() + timeout;
+        while (outstanding.load(std::memory_order_acquire) > 0 && Clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+private:
+    LoadStats& stats;
+    std::atomic<size_t> outstanding{0};
+};
+
+// Metric names of a simulated device: the ones paho-pub sends first, then numbered sensors
+std::string metric_name(size_t i) {
+    static const char* known[] = {"Inputs/Indoor_temperature", "Inputs/Outdoor_temperature", "Inputs/CO2_levels"};
+    return i < 3 ? known[i] : "Inputs/Sensor_" + std::to_string(i);
+}
+
+struct Device {
+    std::string topic;                  // DDATA topic
+    size_t node;                        // Index into the thread's nodes
+    std::vector<double> values;
+};
+
+struct Node {
+    std::string id;
+    uint64_t bd_seq = 0;
+    uint8_t seq = 0;                    // Shared by the node and its devices, wraps at 256
+};
+
+/**
+ * One connection and its share of the nodes: births, the DDATA stream, then the deaths
+ */
+class LoadThread {
+public:
+    LoadThread(const LoadOptions& options, LoadStats& stats, size_t index, size_t first_node, size_t node_count)
+        : options(options), stats(stats), window(stats), rng(index + 1),
+          client(options.server, "paho-load-" + std::to_string(::getpid()) + "-" + std::to_string(index),
+                 mqtt::create_options(options.v5 ? MQTTVERSION_5 : MQTTVERSION_3_1_1)) {
+        for (size_t n = 0; n < node_count; ++n) {
+            Node node;
+            node.id = "Load-" + std::to_string(first_node + n);
+            nodes.push_back(node);
+            for (size_t d = 0; d < options.devices; ++d) {
+                Device device;
+                device.topic = "spBv1.0/" + options.group + "/DDATA/" + node.id + "/Device-" + std::to_string(d);
+                device.node = n;
+                std::uniform_real_distribution<double> initial(15.0, 30.0);
+                for (size_t m = 0; m < options.metrics; ++m) {
+                    device.values.push_back(initial(rng));
+                }
+                devices.push_back(std::move(device));
+            }
+        }
+        for (size_t m = 0; m < options.metrics; ++m) {
+            names.push_back(metric_name(m));
+        }
+    }
+
+    void run() {
+        mqtt::connect_options connOpts;
+        if (options.v5) {
+            connOpts = mqtt::connect_options::v5();
+            connOpts.set_clean_start(true);
+        } else {
+            connOpts.set_clean_session(true);
+        }
+        connOpts.set_max_inflight((int)options.inflight);
+        try {
+            client.connect(connOpts)->wait();
+            for (size_t n = 0; n < nodes.size(); ++n) {
+                birth(n);
+            }
+            stream();
+            for (size_t n = 0; n < nodes.size(); ++n) {
+                death(n);
+            }
+            window.drain(std::chrono::seconds(10));
+            client.disconnect()->wait();
+        } catch (const mqtt::exception& exc) {
+            std::cerr << "Error: " << exc.what() << std::endl;
+        }
+    }
+
+private:
+    void publish(const std::string& topic, const std::string& payload) {
+        window.acquire(options.inflight);
+        auto msg = mqtt::make_message(topic, payload, options.qos, false);
+        if (options.v5) {
+            mqtt::properties props;
+            props.add(publish_ts_property());
+            msg->set_properties(props);
+        }
+        client.publish(msg, (void*)(uintptr_t)steady_us(), window);
+        stats.published.fetch_add(1, std::memory_order_relaxed);
+        stats.bytes.fetch_add(payload.size(), std::memory_order_relaxed);
+    }
+
+    static int64_t now_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    static json metric(const std::string& name, const char* data_type, const json& value, int64_t timestamp) {
+        json m;
+        m["name"] = name;
+        m["timestamp"] = timestamp;
+        m["dataType"] = data_type;
+        m["value"] = value;
+        return m;
+    }
+
+    void birth(size_t n) {
+        Node& node = nodes[n];
+        node.bd_seq++;
+        node.seq = 0;
+        int64_t timestamp = now_ms();
+
+        json nbirth;
+        nbirth["timestamp"] = timestamp;
+        nbirth["seq"] = node.seq++;
+        nbirth["metrics"].push_back(metric("bdSeq", "UInt64", node.bd_seq, timestamp));
+        nbirth["metrics"].push_back(metric("Node Control/Rebirth", "Boolean", false, timestamp));
+        nbirth["metrics"].push_back(metric("Properties/Hardware", "String", "paho-load", timestamp));
+        publish("spBv1.0/" + options.group + "/NBIRTH/" + node.id, encode_payload(nbirth, options.encoding));
+
+        for (const Device& device : devices) {
+            if (device.node != n) {
+                continue;
+            }
+            json dbirth;
+            dbirth["timestamp"] = timestamp;
+            dbirth["seq"] = node.seq++;
+            for (size_t m = 0; m < names.size(); ++m) {
+                dbirth["metrics"].push_back(metric(names[m], "Float", device.values[m], timestamp));
+            }
+            std::string topic = device.topic;
+            topic.replace(topic.find("/DDATA/"), 7, "/DBIRTH/");
+            publish(topic, encode_payload(dbirth, options.encoding));
+        }
+    }
+
+    void death(size_t n) {
+        int64_t timestamp = now_ms();
+        json ndeath;
+        ndeath["timestamp"] = timestamp;
+        ndeath["metrics"].push_back(metric("bdSeq", "UInt64", nodes[n].bd_seq, timestamp));
+        publish("spBv1.0/" + options.group + "/NDEATH/" + nodes[n].id, encode_payload(ndeath, options.encoding));
+    }
+
+    // DDATA round robin over the devices, paced to the rate of the whole thread
+    void stream() {
+        if (devices.empty()) {
+            return;
+        }
+        std::normal_distribution<double> step(0.0, 0.05);
+        auto period = options.rate > 0
+                          ? std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double>(1.0 / (options.rate * devices.size())))
+                          : Clock::duration::zero();
+        auto started = Clock::now();
+        auto next = started;
+
+        // Reused between messages, only the values and timestamps change
+        json ddata;
+        ddata["metrics"] = json::array();
+        for (const std::string& name : names) {
+            ddata["metrics"].push_back(metric(name, "Float", 0.0, 0));
+        }
+
+        for (size_t i = 0; !stop_requested; i = (i + 1) % devices.size()) {
+            if (options.duration_s > 0 &&
+                Clock::now() - started >= std::chrono::duration<double>(options.duration_s)) {
+                break;
+            }
+            if (period > Clock::duration::zero()) {
+                next += period;
+                auto now = Clock::now();
+                if (now < next) {
+                    std::this_thread::sleep_until(next);
+                } else if (now - next > std::chrono::seconds(1)) {
+                    // Too far behind to catch up: do not burst, restart the schedule here
+                    stats.late.fetch_add(1, std::memory_order_relaxed);
+                    next = now;
+                }
+            }
+
+            Device& device = devices[i];
+            int64_t timestamp = now_ms();
+            ddata["timestamp"] = timestamp;
+            ddata["seq"] = nodes[device.node].seq++;
+            json& metrics = ddata["metrics"];
+            for (size_t m = 0; m < device.values.size(); ++m) {
+                device.values[m] += step(rng);
+                metrics[m]["timestamp"] = timestamp;
+                metrics[m]["value"] = device.values[m];
+            }
+            publish(device.topic, encode_payload(ddata, options.encoding));
+        }
+    }
+
+    const LoadOptions& options;
+    LoadStats& stats;
+    InflightWindow window;
+    std::mt19937_64 rng;
+    mqtt::async_client client;
+    std::vector<Node> nodes;
+    std::vector<Device> devices;
+    std::vector<std::string> names;
+};
+
+bool parse_options(int argc, char* argv[], LoadOptions& options) {
+    const char* server = std::getenv("MQTT_SERVER");
+    if (server && *server) {
+        options.server = server;
+    }
+    const char* version = std::getenv("MQTT_VERSION");
+    options.v5 = version && std::string(version) == "5";
+    options.encoding = payload_encoding_from_env();
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        std::string value = argv[i + 1];
+        if (flag == "--nodes") {
+            options.nodes = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (flag == "--devices") {
+            options.devices = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (flag == "--metrics") {
+            options.metrics = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (flag == "--rate") {
+            options.rate = std::atof(value.c_str());
+        } else if (flag == "--threads") {
+            options.threads = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (flag == "--duration") {
+            options.duration_s = std::atof(value.c_str());
+        } else if (flag == "--qos") {
+            options.qos = std::atoi(value.c_str());
+        } else if (flag == "--inflight") {
+            options.inflight = std::max<size_t>(1, std::strtoull(value.c_str(), nullptr, 10));
+        } else if (flag == "--group") {
+            options.group = value;
+        } else if (flag == "--encoding") {
+            if (!payload_encoding_from_string(value, options.encoding)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && options.nodes > 0 && options.rate >= 0 && options.qos >= 0 && options.qos <= 1;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    LoadOptions options;
+    if (!parse_options(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    if (options.threads == 0) {
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    options.threads = std::min(options.threads, options.nodes);
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    std::cout << "Simulating " << options.nodes << " nodes x " << options.devices << " devices x " << options.metrics
+              << " metrics on " << options.threads << " connections to " << options.server << ", target "
+              << (options.rate > 0 ? std::to_string(options.rate * options.nodes * options.devices) + " DDATA/s"
+                                   : std::string("unthrottled"))
+              << ", QoS " << options.qos << ", " << payload_encoding_name(options.encoding) << " payloads" << std::endl;
+
+    LoadStats stats;
+    std::vector<std::unique_ptr<LoadThread>> loads;
+    std::vector<std::thread> threads;
+    size_t first = 0;
+    for (size_t t = 0; t < options.threads; ++t) {
+        size_t count = options.nodes / options.threads + (t < options.nodes % options.threads ? 1 : 0);
+        loads.push_back(std::make_unique<LoadThread>(options, stats, t, first, count));
+        first += count;
+    }
+    auto started = Clock::now();
+    for (auto& load : loads) {
+        threads.emplace_back([&load] { load->run(); });
+    }
+
+    // Report every 5 s until every thread has sent its deaths
+    std::atomic<size_t> running{threads.size()};
+    std::thread joiner([&] {
+        for (auto& t : threads) {
+            t.join();
+            running--;
+        }
+    });
+    uint64_t last_published = 0;
+    auto last_report = started;
+    while (running > 0) {
+        for (int i = 0; i < 50 && running > 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        auto now = Clock::now();
+        double seconds = std::chrono::duration<double>(now - last_report).count();
+        uint64_t published = stats.published.load();
+        LatencyStats::Summary s = stats.ack_latency.take();
+        std::cout << "Published " << (published - last_published) / seconds << " msg/s (total " << published
+                  << ", failed " << stats.failed.load() << ", fell behind " << stats.late.load()
+                  << "x) - ack latency p50: " << s.p50_ms << " ms, p99: " << s.p99_ms << " ms, max: " << s.max_ms
+                  << " ms" << std::endl;
+        last_published = published;
+        last_report = now;
+    }
+    joiner.join();
+
+    double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    std::cout << "Done: " << stats.published.load() << " messages, " << stats.bytes.load() << " payload bytes in "
+              << seconds << " s, " << stats.published.load() / seconds << " msg/s, " << stats.completed.load()
+              << " completed, " << stats.failed.load() << " failed" << std::endl;
+    return 0;
+}
@@ -2,8 +2,12 @@
 #include <nlohmann/json_fwd.hpp>
 #include <string>
 #include <ctime>
+#include <cstdlib>
+#include <map>
 #include <nlohmann/json.hpp>
 #include <mqtt/async_client.h>
+#include "mqttTrace.h"
+#include "payloadEncoding.h"
 
 using json = nlohmann::json;
 
@@ -17,14 +21,77 @@ uint64_t getNextSequence() {
     return ++bdSeq;
 }
 
+/**
+ * MQTT v5 topic aliases: the first publish on a topic sends the full topic plus a new alias,
+ * later ones send only the alias (an empty topic), up to the broker's Topic Alias Maximum.
+ */
+class TopicAliases {
+public:
+    explicit TopicAliases(int maximum) : maximum(maximum) {}
+
+    void publish(mqtt::async_client& client, const std::string& topic, const std::string& payload) {
+        auto msg = mqtt::make_message(topic, payload, 0, false);
+        mqtt::properties props;
+        props.add(publish_ts_property());
+
+        auto it = aliases.find(topic);
+        if (it != aliases.end()) {
+            msg->set_topic("");
+            props.add(mqtt::property(mqtt::property::TOPIC_ALIAS, it->second));
+        } else if ((int)aliases.size() < maximum) {
+            int alias = (int)aliases.size() + 1;
+            aliases[topic] = alias;
+            props.add(mqtt::property(mqtt::property::TOPIC_ALIAS, alias));
+        }
+        msg->set_properties(props);
+        client.publish(msg);
+    }
+
+private:
+    int maximum;
+    std::map<std::string, int> aliases;
+};
+
+// MQTT_VERSION=5 turns on topic aliases and the publish timestamp user property
+bool useMqttV5() {
+    const char* version = std::getenv("MQTT_VERSION");
+    return version && std::string(version) == "5";
+}
+
 int main() {
-    mqtt::async_client client(SERVER_ADDRESS, CLIENT_ID);
+    const bool v5 = useMqttV5();
+    const PayloadEncoding encoding = payload_encoding_from_env();
+    mqtt::async_client client(SERVER_ADDRESS, CLIENT_ID,
+                              mqtt::create_options(v5 ? MQTTVERSION_5 : MQTTVERSION_3_1_1));
 
     mqtt::connect_options connOpts;
-    connOpts.set_clean_session(true);
+    if (v5) {
+        connOpts = mqtt::connect_options::v5();
+        connOpts.set_clean_start(true);
+    } else {
+        connOpts.set_clean_session(true);
+    }
 
     try {
-        client.connect(connOpts)->wait();
+        mqtt::token_ptr conntok = client.connect(connOpts);
+        conntok->wait();
+
+        // Without the property the broker accepts no aliases at all
+        int aliasMaximum = 0;
+        if (v5) {
+            const mqtt::properties& props = conntok->get_connect_response().get_properties();
+            if (props.contains(mqtt::property::TOPIC_ALIAS_MAXIMUM)) {
+                aliasMaximum = mqtt::get<int>(props, mqtt::property::TOPIC_ALIAS_MAXIMUM);
+            }
+        }
+        TopicAliases aliases(aliasMaximum);
+        auto publish = [&](const std::string& topic, const std::string& payload) {
+            if (v5) {
+                aliases.publish(client, topic, payload);
+            } else {
+                client.publish(topic, payload.data(), payload.size(), 0, false);
+            }
+        };
         
         const std::string topic_nbirth("spBv1.0/UCL-SEE-A/NBIRTH/TLab");
         json nbirth_payload;
@@ -94,10 +161,11 @@ int main() {
         nbirth_payload["metrics"][11]["dataType"] = "String";
         nbirth_payload["metrics"][11]["value"] = "Normal";
 
-        std::string publish_payload = nbirth_payload.dump(4);
-        client.publish(topic_nbirth, publish_payload.data(), publish_payload.size(), 0, false);
+        std::string publish_payload = encode_payload(nbirth_payload, encoding);
+        publish(topic_nbirth, publish_payload);
         
-        std::cout << "NBIRTH sent with sequence: " << bdSeq << std::endl;
+        std::cout << "NBIRTH sent with sequence: " << bdSeq << " (" << publish_payload.size() << " bytes "
+                  << payload_encoding_name(encoding) << ")" << std::endl;
         
         // DDATA besked - SKAL matche NBIRTH metric names!
         const std::string topic_data("spBv1.0/UCL-SEE-A/DDATA/TLab/VentSensor1");
@@ -117,10 +185,11 @@ int main() {
         dData_payload["metrics"][1]["dataType"] = "Float";
         dData_payload["metrics"][1]["value"] = 15.2;
         
-        std::string publish_payload_data = dData_payload.dump(4);
-        client.publish(topic_data, publish_payload_data.data(), publish_payload_data.size(), 0, false);
+        std::string publish_payload_data = encode_payload(dData_payload, encoding);
+        publish(topic_data, publish_payload_data);
         
-        std::cout << "DDATA sent with sequence: " << bdSeq << std::endl;
+        std::cout << "DDATA sent with sequence: " << bdSeq << " (" << publish_payload_data.size() << " bytes "
+                  << payload_encoding_name(encoding) << ")" << std::endl;
 
         // NDEATH
         const std::string topic_ndeath("spBv1.0/UCL-SEE-A/NDEATH/TLab");
@@ -128,8 +197,8 @@ int main() {
         ndeath_payload["seq"] = bdSeq;
         ndeath_payload["timestamp"] = timenow;
         
-        std::string publish_payload_ndeath = ndeath_payload.dump(4);
-        client.publish(topic_ndeath, publish_payload_ndeath.data(), publish_payload_ndeath.size(), 0, false);
+        std::string publish_payload_ndeath = encode_payload(ndeath_payload, encoding);
+        publish(topic_ndeath, publish_payload_ndeath);
         
         client.disconnect()->wait();
         
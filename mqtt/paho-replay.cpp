@@ -0,0 +1,326 @@
+/**
+ * @file
+ * @brief Record a live MQTT stream into a capture file and replay it against a broker
+ *
+ *   paho-replay record <file> [--topic <filter>]... [--duration <s>] [--count <n>]
+ *   paho-replay play <file> [--speed <factor>|max] [--nodes <n>] [--qos <0|1>] [--inflight <n>]
+ *
+ * The broker is MQTT_SERVER (default tcp://localhost:1883). Recording subscribes to
+ * spBv1.0/# unless topics are given and runs until Ctrl+C, --duration or --count.
+ * Playing keeps the recorded spacing divided by --speed (1 = real time, max = no pauses).
+ * --nodes N publishes every Sparkplug message N times, copy k going to node "<node>-k",
+ * so a capture of a few nodes loads the subscriber like N times as many. Messages are never
+ * replayed as retained.
+ */
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <csignal>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <mqtt/async_client.h>
+#include "captureFile.h"
+#include "sparkplugTopic.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+std::atomic<bool> stop_requested{false};
+
+void on_signal(int) {
+    stop_requested = true;
+}
+
+std::string server_address() {
+    const char* server = std::getenv("MQTT_SERVER");
+    return server && *server ? server : "tcp://localhost:1883";
+}
+
+void usage() {
+    std::cerr << "usage: paho-replay record <file> [--topic <filter>]... [--duration <s>] [--count <n>]\n"
+              << "       paho-replay play <file> [--speed <factor>|max] [--nodes <n>] [--qos <0|1>] "
+                 "[--inflight <n>]\n";
+}
+
+uint64_t elapsed_us(Clock::time_point since) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - since).count();
+}
+
+// Writes every arriving message, stamped on arrival, from the Paho callback thread
+class Recorder : public virtual mqtt::callback {
+public:
+    Recorder(CaptureWriter& writer, Clock::time_point started) : writer(writer), started(started) {}
+
+    void message_arrived(mqtt::const_message_ptr msg) override {
+        uint64_t offset = elapsed_us(started);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!writer.append(offset, msg->get_topic(), msg->get_payload_str(), msg->get_qos(), msg->is_retained())) {
+            failed = true;
+        }
+    }
+
+    void connection_lost(const std::string& cause) override {
+        std::cerr << "Connection lost: " << cause << std::endl;
+    }
+
+    uint64_t records() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return writer.records();
+    }
+
+    bool write_failed() const { return failed.load(); }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex);
+        writer.flush();
+    }
+
+private:
+    CaptureWriter& writer;
+    Clock::time_point started;
+    std::mutex mutex;
+    std::atomic<bool> failed{false};
+};
+
+int record(const std::string& path, const std::vector<std::string>& args) {
+    std::vector<std::string> filters;
+    double duration_s = 0;
+    uint64_t max_count = 0;
+    for (size_t i = 0; i + 1 < args.size(); i += 2) {
+        if (args[i] == "--topic") {
+            filters.push_back(args[i + 1]);
+        } else if (args[i] == "--duration") {
+            duration_s = std::atof(args[i + 1].c_str());
+        } else if (args[i] == "--count") {
+            max_count = std::strtoull(args[i + 1].c_str(), nullptr, 10);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (filters.empty()) {
+        filters.push_back("spBv1.0/#");
+    }
+
+    CaptureWriter writer(path);
+    if (!writer.usable()) {
+        std::cerr << "Cannot create " << path << std::endl;
+        return 1;
+    }
+
+    mqtt::async_client client(server_address(), "paho-replay-record-" + std::to_string(::getpid()));
+    auto started = Clock::now();
+    Recorder recorder(writer, started);
+    client.set_callback(recorder);
+
+    mqtt::connect_options connOpts;
+    connOpts.set_clean_session(true);
+    try {
+        client.connect(connOpts)->wait();
+        for (const std::string& filter : filters) {
+            client.subscribe(filter, 1)->wait();
+            std::cout << "Recording " << filter << " from " << server_address() << std::endl;
+        }
+
+        auto next_report = Clock::now() + std::chrono::seconds(5);
+        while (!stop_requested && !recorder.write_failed()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            uint64_t count = recorder.records();
+            if ((max_count && count >= max_count) || (duration_s > 0 && elapsed_us(started) >= duration_s * 1e6)) {
+                break;
+            }
+            if (Clock::now() >= next_report) {
+                next_report += std::chrono::seconds(5);
+                std::cout << "Recorded " << count << " messages" << std::endl;
+            }
+        }
+        client.disconnect()->wait();
+    } catch (const mqtt::exception& exc) {
+        std::cerr << "Error: " << exc.what() << std::endl;
+        return 1;
+    }
+
+    recorder.flush();
+    if (recorder.write_failed()) {
+        std::cerr << "Writing " << path << " failed" << std::endl;
+        return 1;
+    }
+    std::cout << "Captured " << writer.records() << " messages on " << writer.topics() << " topics in "
+              << elapsed_us(started) / 1e6 << " s, " << writer.bytes() << " bytes" << std::endl;
+    return 0;
+}
+
+/**
+ * The topic of copy k of a message: node_id gets the suffix "-k". Topics without a node
+ * (STATE, non Sparkplug) are only published once, by copy 0.
+ */
+std::vector<std::string> node_copies(const std::string& topic, size_t nodes) {
+    std::vector<std::string> copies{topic};
+    SparkplugTopic parsed = parse_sparkplug_topic(topic);
+    if (parsed.node_id.empty() || parsed.type == MessageType::STATE) {
+        return copies;
+    }
+    size_t node_end = (size_t)(parsed.node_id.data() - topic.data()) + parsed.node_id.size();
+    for (size_t k = 1; k < nodes; ++k) {
+        copies.push_back(topic.substr(0, node_end) + "-" + std::to_string(k) + topic.substr(node_end));
+    }
+    return copies;
+}
+
+int play(const std::string& path, const std::vector<std::string>& args) {
+    double speed = 1.0;            // 0 = as fast as possible
+    size_t nodes = 1;
+    int qos = -1;                  // As recorded
+    size_t max_inflight = 1000;
+    for (size_t i = 0; i + 1 < args.size(); i += 2) {
+        if (args[i] == "--speed") {
+            speed = args[i + 1] == "max" ? 0.0 : std::atof(args[i + 1].c_str());
+        } else if (args[i] == "--nodes") {
+            nodes = std::max<size_t>(1, std::strtoull(args[i + 1].c_str(), nullptr, 10));
+        } else if (args[i] == "--qos") {
+            qos = std::atoi(args[i + 1].c_str());
+        } else if (args[i] == "--inflight") {
+            max_inflight = std::max<size_t>(1, std::strtoull(args[i + 1].c_str(), nullptr, 10));
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (speed < 0 || qos > 1) {
+        usage();
+        return 2;
+    }
+
+    CaptureReader reader(path);
+    if (!reader.usable()) {
+        std::cerr << "Cannot read " << path << ": " << reader.error() << std::endl;
+        return 1;
+    }
+
+    mqtt::async_client client(server_address(), "paho-replay-play-" + std::to_string(::getpid()));
+    mqtt::connect_options connOpts;
+    connOpts.set_clean_session(true);
+    connOpts.set_max_inflight((int)max_inflight);
+
+    // Topics for every copy, built once per captured topic
+    std::vector<std::vector<std::string>> topics;
+    // QoS 1 publishes still waiting for their PUBACK, oldest first
+    std::deque<std::pair<mqtt::delivery_token_ptr, Clock::time_point>> inflight;
+
+    uint64_t published = 0;
+    uint64_t scheduled = 0;
+    uint64_t payload_bytes = 0;
+    uint64_t max_lag_us = 0;
+    double lag_sum_us = 0;
+    uint64_t acked = 0;
+    double ack_sum_us = 0;
+    uint64_t max_ack_us = 0;
+    // Acks arrive in order, so popping from the front at publish time stamps them closely enough
+    auto complete_oldest = [&](bool block) {
+        if (!block && !inflight.front().first->is_complete()) {
+            return false;
+        }
+        inflight.front().first->wait();
+        uint64_t us = elapsed_us(inflight.front().second);
+        ack_sum_us += us;
+        max_ack_us = std::max(max_ack_us, us);
+        ++acked;
+        inflight.pop_front();
+        return true;
+    };
+
+    try {
+        client.connect(connOpts)->wait();
+        std::cout << "Replaying " << path << " to " << server_address() << " at "
+                  << (speed == 0 ? std::string("max speed") : std::to_string(speed) + "x") << ", " << nodes
+                  << (nodes == 1 ? " copy" : " node copies") << std::endl;
+
+        auto started = Clock::now();
+        CaptureRecord rec;
+        while (!stop_requested && reader.next(rec)) {
+            if (speed > 0) {
+                auto target = started + std::chrono::microseconds((uint64_t)(rec.offset_us / speed));
+                std::this_thread::sleep_until(target);
+                uint64_t lag = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - target).count();
+                max_lag_us = std::max(max_lag_us, lag);
+                lag_sum_us += lag;
+                ++scheduled;
+            }
+            while (topics.size() <= rec.topic_index) {
+                topics.push_back(node_copies(reader.topics()[topics.size()], nodes));
+            }
+
+            int msg_qos = qos >= 0 ? qos : std::min(rec.qos, 1);
+            for (const std::string& topic : topics[rec.topic_index]) {
+                auto msg = mqtt::make_message(topic, rec.payload.data(), rec.payload.size(), msg_qos, false);
+                if (msg_qos == 0) {
+                    client.publish(msg);
+                } else {
+                    while (!inflight.empty() && complete_oldest(inflight.size() >= max_inflight)) {
+                    }
+                    inflight.emplace_back(client.publish(msg), Clock::now());
+                }
+                ++published;
+                payload_bytes += rec.payload.size();
+            }
+        }
+        if (!reader.error().empty()) {
+            std::cerr << "Stopped at a bad record: " << reader.error() << std::endl;
+        }
+        while (!inflight.empty()) {
+            complete_oldest(true);
+        }
+        client.disconnect()->wait();
+
+        double seconds = elapsed_us(started) / 1e6;
+        std::cout << "Published " << published << " messages, " << payload_bytes << " payload bytes in " << seconds
+                  << " s: " << (seconds > 0 ? published / seconds : 0) << " msg/s, "
+                  << (seconds > 0 ? payload_bytes / seconds / 1e6 : 0) << " MB/s" << std::endl;
+        if (scheduled > 0) {
+            std::cout << "Schedule lag - mean: " << lag_sum_us / scheduled / 1000
+                      << " ms, max: " << max_lag_us / 1000.0 << " ms" << std::endl;
+        }
+        if (acked > 0) {
+            std::cout << "Broker ack latency - mean: " << ack_sum_us / acked / 1000 << " ms, max: "
+                      << max_ack_us / 1000.0 << " ms" << std::endl;
+        }
+    } catch (const mqtt::exception& exc) {
+        std::cerr << "Error: " << exc.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        usage();
+        return 2;
+    }
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    std::string mode = argv[1];
+    std::string path = argv[2];
+    std::vector<std::string> args(argv + 3, argv + argc);
+    if (args.size() % 2 != 0) {
+        usage();
+        return 2;
+    }
+    if (mode == "record") {
+        return record(path, args);
+    }
+    if (mode == "play") {
+        return play(path, args);
+    }
+    usage();
+    return 2;
+}
@@ -9,155 +9,298 @@
 #include <algorithm>
 #include <sstream>
 #include <vector>
-#include <tuple>
+#include <atomic>
+#include <string_view>
 #include "spdlogSecurity.h"
+#include "logging.h"
+#include "sparkplugTopic.h"
+#include "subscriberConfig.h"
+#include "subscriptions.h"
+#include "ingestQueue.h"
+#include "ackGate.h"
+#include "cpuAffinity.h"
+#include "latencyStats.h"
+#include "metrics.h"
+#include "metricsServer.h"
+#include "loadController.h"
+#include "sequenceTracker.h"
+#include "deadbandFilter.h"
+#include "rollupAggregator.h"
+#include "metricAliasTable.h"
+#include "mqttTrace.h"
+#include "sink.h"
+#include "fastapiSink.h"
+#include "fileSink.h"
+#ifdef WITH_QUESTDB_ILP
+#include "ilpSink.h"
+#endif
 #include <curl/curl.h>
 #include <nlohmann/json.hpp>
 
-const std::string SERVER_ADDRESS = "tcp://mqtt-broker:1883";
-const std::string CLIENT_ID = "Subscriber";
-const std::string FASTAPI_URL = "http://fastapi:8000";  // Opdater hvis nødvendigt
+// A message waiting for an ingest worker, stamped with its arrival time for latency stats.
+// topic is parsed once on arrival and views into msg, which the item keeps alive.
+// With QoS 1 the ack ticket travels with the message until the sinks are done with it.
+struct IngestItem {
+    mqtt::const_message_ptr msg;
+    SparkplugTopic topic;
+    std::chrono::steady_clock::time_point arrived;
+    AckGate::Ticket ack_ticket;
+};
 
-// Callback for CURL response
-size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    ((std::string*)userp)->append((char*)contents, size * nmemb);
-    return size * nmemb;
-}
+using IngestQueue = IngestWorkers<IngestItem>;
 
 /**
- * Send JSON payload to FastAPI endpoint
+ * Shard key for the ingest workers: hash of group_id + node_id,
+ * so every message of a node (NBIRTH, DDATA, NDEATH...) lands on the same worker in order.
  */
-bool send_to_fastapi(const std::string& endpoint, const std::string& json_payload) {
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        spdlog::error("Failed to initialize CURL");
-        return false;
+size_t node_shard(const SparkplugTopic& topic) {
+    if (topic.node_id.empty()) {
+        return std::hash<std::string_view>{}(topic.topic);
     }
+    return std::hash<std::string_view>{}(topic.group_id) * 31 + std::hash<std::string_view>{}(topic.node_id);
+}
+
+// MessageCallback class
+class MessageCallback : public virtual mqtt::callback {
+private:
+    MQTTSecurityLogger* security_logger;
+    SinkFanOut* sinks;
+    const SubscriberConfig* config;
+    IngestQueue* ingest = nullptr;
+    AckGate* ack_gate = nullptr;
+    LoadController* load_controller = nullptr;
+    SequenceTracker* sequence = nullptr;
+    DeadbandFilter* deadband = nullptr;
+    RollupAggregator* rollups = nullptr;
+    MetricAliasTable* aliases = nullptr;
+    MessageLogSampler* message_log;
+    size_t connection = 0;
+    int callback_cpu = -1;          // CPU_AFFINITY slot of this connection's Paho callback thread
+    bool callback_pinned = false;   // Only touched on the callback thread
     
-    std::string url = FASTAPI_URL + endpoint;
-    std::string response;
-    
-    struct curl_slist* headers = NULL;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-    
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_payload.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 5L);  // 5 second timeout
+    // Fixed before connecting, so the Paho thread reads them unlocked.
+    // With MQTT v5 a subscription's identifier is its index + 1.
+    const std::vector<Subscription>* subscriptions;
+    TopicRouter<size_t> router;
     
-    CURLcode res = curl_easy_perform(curl);
+public:
+    // Publisher to arrival latency from the v5 publish timestamp property
+    LatencyStats publish_latency;
     
-    long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    MessageCallback(MQTTSecurityLogger* logger, SinkFanOut* sinks, const SubscriberConfig* config,
+                    const std::vector<Subscription>* subscriptions, MessageLogSampler* message_log)
+        : security_logger(logger), sinks(sinks), config(config), message_log(message_log),
+          subscriptions(subscriptions), router(build_topic_router(*subscriptions)) {}
     
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
+    void attach_ingest(IngestQueue* queue) { ingest = queue; }
+    void attach_ack_gate(AckGate* gate) { ack_gate = gate; }
+    void attach_load_controller(LoadController* controller) { load_controller = controller; }
+    void attach_sequence_tracker(SequenceTracker* tracker) { sequence = tracker; }
+    void attach_deadband_filter(DeadbandFilter* filter) { deadband = filter; }
+    void attach_rollups(RollupAggregator* aggregator) { rollups = aggregator; }
+    void attach_alias_table(MetricAliasTable* table) { aliases = table; }
     
-    if (res != CURLE_OK) {
-        spdlog::error("Failed to send to FastAPI {}: {}", endpoint, curl_easy_strerror(res));
-        return false;
+    // The callback thread belongs to Paho, so it is pinned from inside on the first message
+    void pin_callback_thread(size_t conn, int cpu) {
+        connection = conn;
+        callback_cpu = cpu;
     }
     
-    if (http_code >= 200 && http_code < 300) {
-        spdlog::info("FastAPI {} success (HTTP {}): {}", endpoint, http_code, response);
-        return true;
-    } else {
-        spdlog::error("FastAPI {} error (HTTP {}): {}", endpoint, http_code, response);
-        return false;
+    // Hand a message to the sinks: only its metrics outside their deadband, unless the load controller sheds it.
+    // The rollups see every sample, so their min/max/avg stay exact whatever is filtered or shed.
+    void forward(const DecodedMessage::Ptr& decoded) {
+        if (rollups) {
+            rollups->observe(*decoded);
+        }
+        DecodedMessage::Ptr out = deadband ? deadband->filter(decoded) : decoded;
+        if (!out) {
+            return;
+        }
+        if (load_controller && !load_controller->admit(*out)) {
+            return;
+        }
+        sinks->publish(out);
     }
-}
-
-// MessageCallback class
-class MessageCallback : public virtual mqtt::callback {
-private:
-    MQTTSecurityLogger* security_logger;
     
     /**
-     * Parse Sparkplug B topic to extract components
-     * Format: spBv1.0/{group_id}/{message_type}/{node_id}/{device_id}
+     * Runs on the Paho callback thread: only hand the message to a worker and return,
+     * so a slow sink never stalls the broker connection.
      */
-    std::tuple<std::string, std::string, std::string, std::string> parse_topic(const std::string& topic) {
-        std::vector<std::string> parts;
-        std::stringstream ss(topic);
-        std::string item;
-        
-        while (std::getline(ss, item, '/')) {
-            parts.push_back(item);
+    void message_arrived(mqtt::const_message_ptr msg) override {
+        if (callback_cpu >= 0 && !callback_pinned) {
+            callback_pinned = true;
+            int cpu = pin_current_thread_once(callback_cpu);
+            if (cpu == callback_cpu) {
+                spdlog::info("Connection {} callback thread pinned to CPU {}", connection, cpu);
+            } else if (cpu >= 0) {
+                spdlog::info("Connection {} shares its callback thread, already pinned to CPU {}", connection, cpu);
+            } else {
+                spdlog::warn("Connection {} callback thread: could not pin to CPU {}", connection, callback_cpu);
+            }
         }
+        IngestItem item;
+        item.arrived = std::chrono::steady_clock::now();
+        item.topic = parse_sparkplug_topic(msg->get_topic());
         
-        if (parts.size() >= 4) {
-            std::string group_id = parts[1];      // UCL-SEE-A
-            std::string msg_type = parts[2];      // NBIRTH, DDATA, etc.
-            std::string node_id = parts[3];       // TLab
-            std::string device_id = parts.size() > 4 ? parts[4] : "";  // VentSensor1 (optional)
-            return {group_id, msg_type, node_id, device_id};
+        // The subscription the message came in on picks the handler: by identifier with v5,
+        // otherwise by matching the topic against the filter trie
+        size_t index = subscriptions->size();
+        if (config->mqtt_version == 5) {
+            const mqtt::properties& props = msg->get_properties();
+            if (props.contains(mqtt::property::SUBSCRIPTION_IDENTIFIER)) {
+                int id = mqtt::get<int>(props, mqtt::property::SUBSCRIPTION_IDENTIFIER);
+                if (id > 0 && (size_t)id <= subscriptions->size()) {
+                    index = (size_t)id - 1;
+                }
+            }
+            int64_t published = publish_ts_us(props);
+            if (published > 0) {
+                int64_t us = epoch_us_now() - published;
+                publish_latency.record(std::chrono::microseconds(std::max<int64_t>(0, us)));
+            }
+        }
+        if (index == subscriptions->size()) {
+            const size_t* matched = router.match(item.topic.topic);
+            if (matched) {
+                index = *matched;
+            }
+        }
+        if (index < subscriptions->size()) {
+            item.topic.type = handled_type(item.topic, (*subscriptions)[index].handler);
+        }
+        if (ack_gate && msg->get_qos() > 0) {
+            item.ack_ticket = ack_gate->acquire();
+        }
+        item.msg = std::move(msg);
+        if (!ingest) {
+            process_message(item);
+        } else {
+            size_t shard = node_shard(item.topic);
+            ingest->submit(shard, std::move(item));
+        }
+        // Slow down the receive path while too many messages are still on their way to the sinks
+        if (ack_gate) {
+            ack_gate->wait_for_window();
         }
-        
-        return {"", "", "", ""};
     }
     
-public:
-    MessageCallback(MQTTSecurityLogger* logger) : security_logger(logger) {}
-    
-    void message_arrived(mqtt::const_message_ptr msg) override {
-        std::string topic = msg->get_topic();
-        std::string payload = msg->to_string();
+    // Decode once, then share the result with security analysis and every sink
+    void process_message(const IngestItem& item) {
+        using Clock = std::chrono::steady_clock;
+        PipelineMetrics& metrics = pipeline_metrics();
+        auto started = Clock::now();
+        metrics.queue_wait.record(started - item.arrived);
+        
+        const std::string& payload = item.msg->get_payload_str();
         
-        std::cout << "Message arrived on topic: " << topic << std::endl;
-        std::cout << "Payload: " << payload << std::endl;
+        // Per-message lines only at LOG_MESSAGE_LEVEL and 1 in LOG_SAMPLE_EVERY
+        bool log_this = message_log->should_log();
+        spdlog::level::level_enum level = message_log->log_level();
+        if (log_this) {
+            spdlog::log(level, "Message arrived on topic: {} ({} bytes)", item.topic.topic, payload.size());
+            spdlog::log(level, "Payload: {}", payload);
+        }
         
-        auto [group_id, msg_type, node_id, device_id] = parse_topic(topic);
+        // The decoded message keeps the MQTT message (topic + payload bytes) and its ack ticket alive.
+        // Metrics get their slot in the node's alias table, alias only ones their name from the birth
+        DecodedMessage::Ptr decoded = DecodedMessage::decode(item.msg, item.topic, payload, item.arrived,
+                                                             aliases, item.ack_ticket);
+        const SparkplugTopic& topic = decoded->topic;
+        auto decoded_at = Clock::now();
+        metrics.decode.record(decoded_at - started);
         
-        // Handle different message types
-        if (topic.find("/NBIRTH/") != std::string::npos) {
-            spdlog::info("Processing NBIRTH message for node: {}", node_id);
-            security_logger->analyze_nbirth_message(topic, payload);
-            
-            // Send to FastAPI
-            std::string endpoint = "/ingest/nbirth/" + group_id + "/" + node_id;
-            if (send_to_fastapi(endpoint, payload)) {
-                spdlog::info("NBIRTH data successfully sent to database");
-            }
+        PipelineMetrics::TypeCounters& counters = metrics.type(topic.type);
+        counters.messages.fetch_add(1, std::memory_order_relaxed);
+        counters.bytes.fetch_add(payload.size(), std::memory_order_relaxed);
+        if (!decoded->ok) {
+            counters.errors.fetch_add(1, std::memory_order_relaxed);
         }
-        else if (topic.find("/DDATA/") != std::string::npos) {
-            spdlog::info("Processing DDATA message for device: {}/{}", node_id, device_id);
-            security_logger->analyze_ddata_message(topic, payload);
-            
-            // Send to FastAPI
-            std::string endpoint = "/ingest/ddata/" + group_id + "/" + node_id + "/" + device_id;
-            if (send_to_fastapi(endpoint, payload)) {
-                spdlog::info("DDATA data successfully sent to database");
+        
+        // Redelivered or retried messages were already analyzed and stored: drop them here
+        SeqVerdict verdict = sequence ? sequence->check(*decoded) : SeqVerdict::InOrder;
+        if (verdict == SeqVerdict::Duplicate) {
+            if (log_this) {
+                spdlog::log(level, "Dropping duplicate seq {} on topic: {}", decoded->seq, topic.topic);
             }
+            return;
         }
-        else if (topic.find("/NDATA/") != std::string::npos) {
-            spdlog::info("Processing NDATA message for node: {}", node_id);
-            security_logger->analyze_ndata_message(topic, payload);
-            
-            // TODO: Add NDATA endpoint if needed
-            // std::string endpoint = "/ingest/ndata/" + group_id + "/" + node_id;
-            // send_to_fastapi(endpoint, payload);
-        }
-        else if (topic.find("/NDEATH/") != std::string::npos) {
-            spdlog::info("Processing NDEATH message for node: {}", node_id);
-            security_logger->analyze_ndeath_message(topic, payload);
-            
-            // TODO: Add NDEATH endpoint if needed
-            // std::string endpoint = "/ingest/ndeath/" + group_id + "/" + node_id;
-            // send_to_fastapi(endpoint, payload);
-        }
-        else if (topic.find("/NCMD/") != std::string::npos) {
-            spdlog::info("Processing NCMD message for node: {}", node_id);
-            security_logger->analyze_ncmd_message(topic, payload);
-        }
-        else if (topic.find("/DCMD/") != std::string::npos) {
-            spdlog::info("Processing DCMD message for device: {}/{}", node_id, device_id);
-            security_logger->analyze_dcmd_message(topic, payload);
+        if (verdict != SeqVerdict::InOrder && log_this) {
+            spdlog::log(level, "Sequence {} at seq {} on topic: {}", seq_verdict_name(verdict), decoded->seq,
+                        topic.topic);
         }
-        else {
-            spdlog::warn("Unknown message type on topic: {}", topic);
+        
+        // Analysis includes handing the message to the sink queues, which is only an enqueue
+        switch (topic.type) {
+        case MessageType::NBIRTH:
+            if (log_this) {
+                spdlog::log(level, "Processing NBIRTH message for node: {}", topic.node_id);
+            }
+            security_logger->analyze_nbirth_message(*decoded);
+            // Every instance sees the births, only the owner stores them
+            if (config->owns_node(topic)) {
+                forward(decoded);
+            }
+            break;
+        case MessageType::DDATA:
+            if (log_this) {
+                spdlog::log(level, "Processing DDATA message for device: {}/{}", topic.node_id, topic.device_id);
+            }
+            security_logger->analyze_ddata_message(*decoded);
+            forward(decoded);
+            break;
+        case MessageType::NDATA:
+            if (log_this) {
+                spdlog::log(level, "Processing NDATA message for node: {}", topic.node_id);
+            }
+            security_logger->analyze_ndata_message(*decoded);
+            forward(decoded);
+            break;
+        case MessageType::NDEATH:
+            if (log_this) {
+                spdlog::log(level, "Processing NDEATH message for node: {}", topic.node_id);
+            }
+            security_logger->analyze_ndeath_message(*decoded);
+            if (config->owns_node(topic)) {
+                forward(decoded);
+            }
+            break;
+        case MessageType::DBIRTH:
+        case MessageType::DDEATH:
+            if (log_this) {
+                spdlog::log(level, "Processing {} message for device: {}/{}", message_type_name(topic.type),
+                            topic.node_id, topic.device_id);
+            }
+            // Like the node's own birth and death: seen by every instance, stored by the owner
+            if (config->owns_node(topic)) {
+                forward(decoded);
+            }
+            break;
+        case MessageType::STATE:
+            // Host application online/offline, nothing to analyze or store
+            if (log_this) {
+                spdlog::log(level, "STATE message on topic: {}", topic.topic);
+            }
+            break;
+        case MessageType::NCMD:
+            if (log_this) {
+                spdlog::log(level, "Processing NCMD message for node: {}", topic.node_id);
+            }
+            security_logger->analyze_ncmd_message(*decoded);
+            break;
+        case MessageType::DCMD:
+            if (log_this) {
+                spdlog::log(level, "Processing DCMD message for device: {}/{}", topic.node_id, topic.device_id);
+            }
+            security_logger->analyze_dcmd_message(*decoded);
+            break;
+        default:
+            // Counted per type in /metrics; per message only with the sampled message log
+            if (log_this) {
+                spdlog::log(level, "Unhandled message type on topic: {}", topic.topic);
+            }
+            break;
         }
+        metrics.analysis.record(Clock::now() - decoded_at);
     }
     
     void connection_lost(const std::string& cause) override {
@@ -166,14 +309,145 @@ public:
     }
 };
 
+/**
+ * Create the sinks listed in SINKS, each with its own batching/retry policy and, when
+ * SPOOL_DIR is set, its own disk spool (named after the sink plus spool_suffix)
+ */
+void build_sinks(const SubscriberConfig& config, const SpoolOptions& spool_options, SinkFanOut& sinks,
+                 const std::string& spool_suffix = "") {
+    auto spool_for = [&spool_options, &spool_suffix](const std::string& name) -> std::unique_ptr<Spool> {
+        if (spool_options.dir.empty()) {
+            return nullptr;
+        }
+        return std::make_unique<Spool>(spool_options, name + spool_suffix);
+    };
+
+    std::stringstream list(config.sinks);
+    std::string name;
+    while (std::getline(list, name, ',')) {
+        if (name == "fastapi") {
+            SinkPolicy defaults;
+            defaults.batch_max_messages = 500;
+            defaults.batch_max_latency = std::chrono::milliseconds(200);
+            sinks.add(std::make_unique<FastApiSink>(config.fastapi_url, config.http_pool_size, config.http_timeout_ms),
+                      SinkPolicy::from_env("FASTAPI", defaults), spool_for(name));
+        } else if (name == "file") {
+            SinkPolicy defaults;
+            defaults.batch_max_messages = 1000;
+            defaults.batch_max_latency = std::chrono::milliseconds(1000);
+            sinks.add(std::make_unique<FileSink>(config.file_sink_path), SinkPolicy::from_env("FILE", defaults),
+                      spool_for(name));
+        } else if (name == "ilp_tcp" || name == "ilp_http") {
+#ifdef WITH_QUESTDB_ILP
+            bool tcp = name == "ilp_tcp";
+            SinkPolicy defaults;
+            defaults.batch_max_messages = 1000;
+            defaults.batch_max_latency = std::chrono::milliseconds(500);
+            sinks.add(std::make_unique<IlpSink>(name, tcp ? config.questdb_ilp_tcp_conf : config.questdb_ilp_http_conf),
+                      SinkPolicy::from_env(tcp ? "ILP_TCP" : "ILP_HTTP", defaults), spool_for(name));
+#else
+            spdlog::error("Sink {} requested but paho-sub was built without PAHO_SUB_WITH_QUESTDB_ILP", name);
+            continue;
+#endif
+        } else {
+            if (!name.empty()) {
+                spdlog::error("Unknown sink: {}", name);
+            }
+            continue;
+        }
+        spdlog::info("Sink enabled: {}", name);
+    }
+}
+
+/**
+ * Subscribe to a topic filter, optionally through the shared subscription group so the broker
+ * hands each message to only one subscriber instance. With MQTT v5 the filter gets
+ * subscription identifier `id`, which tells the callback the handler.
+ */
+void subscribe_topic(mqtt::async_client& client, MQTTSecurityLogger& security_logger,
+                     const SubscriberConfig& config, const Subscription& sub, int id) {
+    std::string filter = sub.filter;
+    if (sub.shared && !config.mqtt_share_group.empty()) {
+        filter = "$share/" + config.mqtt_share_group + "/" + sub.filter;
+    }
+    mqtt::properties props;
+    if (config.mqtt_version != 5) {
+        id = 0;
+    }
+    if (id > 0) {
+        props.add(mqtt::property(mqtt::property::SUBSCRIPTION_IDENTIFIER, id));
+    }
+    client.subscribe(filter, config.mqtt_qos, mqtt::subscribe_options(), props);
+    security_logger.log_topic_subscription(filter);
+    spdlog::info("Subscribed to: {} -> {} (subscription id {})", filter, message_type_name(sub.handler), id);
+}
+
+void log_ingest_stats(const IngestQueue& ingest, size_t connection) {
+    for (size_t i = 0; i < ingest.size(); ++i) {
+        const auto& q = ingest.queue(i);
+        const auto& c = q.stats();
+        spdlog::info("Connection {} ingest worker {} - depth: {}, high watermark: {}, enqueued: {}, dequeued: {}, "
+                     "dropped oldest: {}, dropped newest: {}, blocked: {}",
+                     connection, i, q.depth(), c.high_watermark.load(), c.enqueued.load(), c.dequeued.load(),
+                     c.dropped_oldest.load(), c.dropped_newest.load(), c.blocked.load());
+    }
+}
+
+/**
+ * One broker connection with everything behind it: its own callback, ingest workers and sinks
+ * with their own batches and spools. With CPU_AFFINITY the callback thread and the workers
+ * each get the next CPU of the list.
+ * Members are destroyed bottom up: the workers drain into the sinks before those stop.
+ */
+struct Connection {
+    size_t index = 0;
+    std::string client_id;
+    SinkFanOut sinks;
+    std::unique_ptr<MessageCallback> cb;
+    std::unique_ptr<mqtt::async_client> client;
+    std::unique_ptr<IngestQueue> ingest;
+};
+
+/**
+ * Which subscriptions a connection makes. With a share group every connection joins the group
+ * for the shared filters (the broker balances them) and only connection 0 takes the plain ones,
+ * so births are not delivered twice. Without a group the filters are dealt out round robin.
+ */
+bool connection_subscribes(const SubscriberConfig& config, const Subscription& sub, size_t sub_index,
+                           size_t connection) {
+    if (config.mqtt_connections <= 1) {
+        return true;
+    }
+    if (!config.mqtt_share_group.empty()) {
+        return sub.shared || connection == 0;
+    }
+    return sub_index % config.mqtt_connections == connection;
+}
+
 int main() 
 {
     try 
     {
         // Initialize CURL globally
         curl_global_init(CURL_GLOBAL_ALL);
+        SubscriberConfig config = SubscriberConfig::from_env();
         
-        auto filelog = spdlog::basic_logger_mt("filelog", "logs/mqttlog.log");
+        // All logging goes through spdlog's async pool, so it never writes on an ingest thread
+        LogOptions log_options = LogOptions::from_env();
+        init_async_logging(log_options);
+        MessageLogSampler message_log(log_options);
+        
+        std::string config_error = config.startup_error();
+        if (!config_error.empty()) {
+            spdlog::error("Not starting: {}", config_error);
+            curl_global_cleanup();
+            spdlog::shutdown();
+            return 1;
+        }
+        
+        auto filelog = make_async_logger("filelog",
+            {std::make_shared<spdlog::sinks::basic_file_sink_mt>("logs/mqttlog.log")});
+        spdlog::register_logger(filelog);
         filelog->set_level(spdlog::level::debug);
         
         // Setup security logger with database handler
@@ -182,46 +456,214 @@ int main()
         security_logger.log_subscriber_start();
         
         spdlog::info("Starting MQTT subscriber with security logging and FastAPI integration...");
-        spdlog::info("FastAPI URL: {}", FASTAPI_URL);
+        spdlog::info("FastAPI URL: {}", config.fastapi_url);
+        
+        // QoS 1: at most max_inflight messages between arrival and the sinks (backpressure only,
+        // Paho has acked them on receipt). Declared first so it outlives every ticket.
+        AckGate ack_gate(config.mqtt_max_inflight, std::chrono::milliseconds(config.mqtt_inflight_wait_ms));
+        if (config.mqtt_qos == 1) {
+            spdlog::info("QoS 1 with persistent session, max in flight: {} (wait at most {} ms)",
+                         config.mqtt_max_inflight, config.mqtt_inflight_wait_ms);
+        }
         
-        mqtt::async_client client(SERVER_ADDRESS, CLIENT_ID);
-        MessageCallback cb(&security_logger);
-        client.set_callback(cb);
+        if (!config.mqtt_share_group.empty()) {
+            spdlog::info("Shared subscription group: {} (instance {} of {})", config.mqtt_share_group,
+                         config.instance_index, config.instance_count);
+        }
         
-        mqtt::connect_options connOpts;
-        connOpts.set_clean_session(true);
+        // Topic filters and their handlers, from SUBSCRIPTIONS_FILE
+        const std::vector<Subscription> subscriptions = load_subscriptions(config.subscriptions_file);
         
-        try 
-        {
-            client.connect(connOpts)->wait();
-            spdlog::info("Connected to the MQTT broker!");
-            security_logger.log_broker_connection(SERVER_ADDRESS, CLIENT_ID);
-            
-            // Subscribe to specific topics
-            const std::string topic_nbirth("spBv1.0/UCL-SEE-A/NBIRTH/TLab");
-            client.subscribe(topic_nbirth, 0);
-            security_logger.log_topic_subscription(topic_nbirth);
-            spdlog::info("Subscribed to: {}", topic_nbirth);
-            
-            const std::string topic_data("spBv1.0/UCL-SEE-A/DDATA/TLab/VentSensor1");
-            client.subscribe(topic_data, 0);
-            security_logger.log_topic_subscription(topic_data);
-            spdlog::info("Subscribed to: {}", topic_data);
+        // Decouple the Paho callback thread from analysis and the sinks
+        OverflowPolicy overflow = overflow_policy_from_string(config.ingest_overflow);
+        std::vector<int> cpus = parse_cpu_list(config.cpu_affinity);
+        SpoolOptions spool_options = SpoolOptions::from_env();
+        
+        // Bigger batches, then changes-only DDATA, then shedding data while the sinks fall behind.
+        // Declared before the connections so their workers can still ask it while draining.
+        LoadController load_controller(LoadControlOptions::from_env());
+        
+        // Per-node seq state, shared by all connections since a node may arrive on any of them
+        SequenceTracker sequence_tracker;
+        
+        // Per-node metric slots and alias bindings from the births, shared the same way
+        MetricAliasTable alias_table;
+        
+        // Report by exception in front of the sinks (DEADBAND_FILE), also shared by all connections
+        DeadbandOptions deadband_options = DeadbandOptions::load(config.deadband_file);
+        if (!deadband_options.empty() && !config.mqtt_share_group.empty()) {
+            // Each instance would compare against the values only it saw, not the last one stored
+            spdlog::error("DEADBAND_FILE cannot be combined with MQTT_SHARE_GROUP, deadband filtering is off");
+            deadband_options = DeadbandOptions();
+        }
+        DeadbandFilter deadband(std::move(deadband_options));
+        if (deadband.enabled()) {
+            spdlog::info("Deadband filtering enabled from {}", config.deadband_file);
+        }
+        
+        // 1s/1m/1h min/max/avg/count/last per metric, written to the rollup tables through FastAPI
+        RollupOptions rollup_options = RollupOptions::from_env();
+        if (rollup_options.enabled && !config.mqtt_share_group.empty()) {
+            // Each instance only sees its share of the data, so its buckets would be partial
+            spdlog::error("ROLLUPS cannot be combined with MQTT_SHARE_GROUP, rollups are off");
+            rollup_options.enabled = false;
+        }
+        RollupAggregator rollups(rollup_options);
+        std::unique_ptr<RollupWriter> rollup_writer;
+        if (rollup_options.enabled) {
+            rollup_writer = std::make_unique<RollupWriter>(rollups, rollup_options, config.fastapi_url,
+                                                           config.http_timeout_ms);
+            spdlog::info("Rollups enabled, flushed every {} ms", rollup_options.flush_interval.count());
+        }
+        
+        // MQTT_CONNECTIONS broker connections, each with its own workers and sinks
+        std::vector<std::unique_ptr<Connection>> connections;
+        for (size_t c = 0; c < config.mqtt_connections; ++c) {
+            auto conn = std::make_unique<Connection>();
+            conn->index = c;
+            conn->client_id = config.mqtt_client_id;
+            std::string suffix;
+            if (config.mqtt_connections > 1) {
+                suffix = "-c" + std::to_string(c);
+                conn->client_id += suffix;
+            }
             
-            const std::string topic_death("spBv1.0/UCL-SEE-A/NDEATH/TLab");
-            client.subscribe(topic_death, 0);
-            security_logger.log_topic_subscription(topic_death);
-            spdlog::info("Subscribed to: {}", topic_death);
+            // Sinks selected at runtime (SINKS=fastapi,ilp_tcp,ilp_http,file), each on its own thread.
+            // Connection 0 keeps the plain spool names, so a single connection setup finds its old spools.
+            build_sinks(config, spool_options, conn->sinks, c == 0 ? "" : suffix);
+            if (conn->sinks.empty() && c == 0) {
+                spdlog::warn("No sinks configured - messages are only analyzed");
+            }
             
-            // Subscribe to wildcard topics
-            client.subscribe("spBv1.0/+/NDATA/+", 0);
-            spdlog::info("Subscribed to: spBv1.0/+/NDATA/+");
+            conn->cb = std::make_unique<MessageCallback>(&security_logger, &conn->sinks, &config, &subscriptions,
+                                                         &message_log);
+            conn->client = std::make_unique<mqtt::async_client>(
+                config.mqtt_server, conn->client_id,
+                mqtt::create_options(config.mqtt_version == 5 ? MQTTVERSION_5 : MQTTVERSION_3_1_1));
+            MessageCallback* cb = conn->cb.get();
+            conn->ingest = std::make_unique<IngestQueue>(config.ingest_workers, config.ingest_queue_capacity, overflow,
+                [cb](IngestItem& item) { cb->process_message(item); });
+            cb->attach_ingest(conn->ingest.get());
+            cb->attach_sequence_tracker(&sequence_tracker);
+            cb->attach_alias_table(&alias_table);
+            if (deadband.enabled()) {
+                cb->attach_deadband_filter(&deadband);
+            }
+            if (rollup_writer) {
+                cb->attach_rollups(&rollups);
+            }
+            if (config.mqtt_qos == 1) {
+                cb->attach_ack_gate(&ack_gate);
+            }
+            if (load_controller.enabled()) {
+                load_controller.add_sinks(&conn->sinks);
+                cb->attach_load_controller(&load_controller);
+            }
             
-            client.subscribe("spBv1.0/+/NCMD/+", 0);
-            spdlog::info("Subscribed to: spBv1.0/+/NCMD/+");
+            // One CPU slot for the Paho callback thread, then one per worker
+            size_t slots = conn->ingest->size() + 1;
+            if (!cpus.empty()) {
+                cb->pin_callback_thread(c, cpus[(c * slots) % cpus.size()]);
+            }
+            for (size_t w = 0; w < conn->ingest->size() && !cpus.empty(); ++w) {
+                int cpu = cpus[(c * slots + 1 + w) % cpus.size()];
+                if (pin_thread_to_cpu(conn->ingest->native_handle(w), cpu)) {
+                    spdlog::info("Connection {} ingest worker {} pinned to CPU {}", c, w, cpu);
+                } else {
+                    spdlog::warn("Connection {} ingest worker {}: could not pin to CPU {}", c, w, cpu);
+                }
+            }
+            spdlog::info("Connection {} ({}): {} ingest workers, capacity {} per worker, overflow policy {}",
+                         c, conn->client_id, conn->ingest->size(), conn->ingest->queue(0).capacity(),
+                         overflow_policy_name(overflow));
             
-            client.subscribe("spBv1.0/+/DCMD/+/+", 0);
-            spdlog::info("Subscribed to: spBv1.0/+/DCMD/+/+");
+            conn->client->set_callback(*cb);
+            connections.push_back(std::move(conn));
+        }
+        
+        // Queue depths are read on scrape; the server is declared after the connections so it stops first
+        pipeline_metrics().add_collector([&connections](std::string& out) {
+            out += "# TYPE paho_sub_ingest_queue_depth gauge\n";
+            for (const auto& conn : connections) {
+                for (size_t w = 0; w < conn->ingest->size(); ++w) {
+                    out += "paho_sub_ingest_queue_depth{connection=\"" + std::to_string(conn->index) + "\",worker=\"" +
+                           std::to_string(w) + "\"} " + std::to_string(conn->ingest->queue(w).depth()) + "\n";
+                }
+            }
+            out += "# TYPE paho_sub_sink_queue_depth gauge\n";
+            for (const auto& conn : connections) {
+                for (const auto& sink : conn->sinks.queue_depths()) {
+                    out += "paho_sub_sink_queue_depth{connection=\"" + std::to_string(conn->index) + "\",sink=\"" +
+                           sink.first + "\"} " + std::to_string(sink.second) + "\n";
+                }
+            }
+        });
+        pipeline_metrics().add_collector([&ack_gate](std::string& out) {
+            out += "# TYPE paho_sub_ack_outstanding gauge\n";
+            out += "paho_sub_ack_outstanding " + std::to_string(ack_gate.outstanding()) + "\n";
+            out += "# TYPE paho_sub_ack_wait_timeouts_total counter\n";
+            out += "paho_sub_ack_wait_timeouts_total " + std::to_string(ack_gate.stats().timeouts.load()) + "\n";
+        });
+        pipeline_metrics().add_collector([&sequence_tracker](std::string& out) {
+            out += "# TYPE paho_sub_seq_nodes gauge\n";
+            out += "paho_sub_seq_nodes " + std::to_string(sequence_tracker.nodes()) + "\n";
+        });
+        pipeline_metrics().add_collector([&alias_table](std::string& out) {
+            out += "# TYPE paho_sub_alias_nodes gauge\n";
+            out += "paho_sub_alias_nodes " + std::to_string(alias_table.nodes()) + "\n";
+        });
+        if (deadband.enabled()) {
+            pipeline_metrics().add_collector([&deadband](std::string& out) {
+                out += "# TYPE paho_sub_deadband_metrics gauge\n";
+                out += "paho_sub_deadband_metrics " + std::to_string(deadband.tracked()) + "\n";
+            });
+        }
+        if (rollup_writer) {
+            pipeline_metrics().add_collector([&rollups](std::string& out) {
+                out += "# TYPE paho_sub_rollup_series gauge\n";
+                out += "paho_sub_rollup_series " + std::to_string(rollups.series()) + "\n";
+            });
+        }
+        std::unique_ptr<MetricsServer> metrics_server;
+        if (config.metrics_port > 0) {
+            metrics_server = std::make_unique<MetricsServer>(config.metrics_bind, (int)config.metrics_port,
+                                                             [] { return pipeline_metrics().render(); });
+        }
+        
+        mqtt::connect_options connOpts;
+        // QoS 1 keeps the session (subscriptions and unacked messages) on the broker across restarts
+        bool persistent = config.mqtt_qos == 1;
+        if (config.mqtt_version == 5) {
+            connOpts = mqtt::connect_options::v5();
+            connOpts.set_clean_start(!persistent);
+            if (persistent) {
+                int receive_max = (int)std::min<size_t>(65535, std::max<size_t>(1, config.mqtt_max_inflight));
+                connOpts.set_properties({
+                    {mqtt::property::SESSION_EXPIRY_INTERVAL, config.mqtt_session_expiry_s},
+                    {mqtt::property::RECEIVE_MAXIMUM, receive_max},
+                });
+            }
+        } else {
+            connOpts.set_clean_session(!persistent);
+        }
+        if (persistent) {
+            connOpts.set_automatic_reconnect(true);
+        }
+        
+        try 
+        {
+            for (auto& conn : connections) {
+                conn->client->connect(connOpts)->wait();
+                spdlog::info("Connection {} connected to the MQTT broker (MQTT v{})!", conn->index,
+                             config.mqtt_version == 5 ? "5" : "3.1.1");
+                security_logger.log_broker_connection(config.mqtt_server, conn->client_id);
+                
+                for (size_t i = 0; i < subscriptions.size(); ++i) {
+                    if (connection_subscribes(config, subscriptions[i], i, conn->index)) {
+                        subscribe_topic(*conn->client, security_logger, config, subscriptions[i], (int)i + 1);
+                    }
+                }
+            }
             
             // Start periodic security checks thread
             std::thread security_thread([&security_logger]() {
@@ -235,13 +677,49 @@ int main()
             spdlog::info("Subscriber running... Press Ctrl+C to stop");
             spdlog::info("Waiting for messages...");
             
+            auto next_stats = std::chrono::steady_clock::now() + std::chrono::seconds(60);
             while (true) {
-                std::this_thread::sleep_for(std::chrono::seconds(60));
+                std::this_thread::sleep_for(load_controller.interval());
+                load_controller.evaluate();
+                if (std::chrono::steady_clock::now() < next_stats) {
+                    continue;
+                }
+                next_stats += std::chrono::seconds(60);
+                
+                spdlog::info("Load level: {}", load_level_name(load_controller.level()));
+                for (auto& conn : connections) {
+                    log_ingest_stats(*conn->ingest, conn->index);
+                }
+                if (config.mqtt_qos == 1) {
+                    const auto& a = ack_gate.stats();
+                    spdlog::info("Ack gate - outstanding: {}, high watermark: {}, released: {}, waits: {}, timeouts: {}",
+                                 ack_gate.outstanding(), a.high_watermark.load(), a.released.load(), a.waits.load(),
+                                 a.timeouts.load());
+                }
+                for (auto& conn : connections) {
+                    if (config.mqtt_version == 5) {
+                        LatencyStats::Summary s = conn->cb->publish_latency.take();
+                        spdlog::info("Connection {} MQTT publish to arrival - messages: {}, latency p50: {:.2f} ms, "
+                                     "p99: {:.2f} ms, max: {:.2f} ms",
+                                     conn->index, s.count, s.p50_ms, s.p99_ms, s.max_ms);
+                    }
+                    conn->sinks.log_stats();
+                }
             }
             
             // Cleanup (won't be reached without signal handling)
             security_logger.log_disconnect();
-            client.disconnect()->wait();
+            for (auto& conn : connections) {
+                conn->client->disconnect()->wait();
+            }
+            ack_gate.close();
+            for (auto& conn : connections) {
+                conn->ingest->stop();
+                conn->sinks.stop();
+            }
+            if (rollup_writer) {
+                rollup_writer->stop();
+            }
             security_thread.detach();
             
         } catch (const mqtt::exception& exc) {
@@ -250,14 +728,17 @@ int main()
             security_logger.log_connection_failure(exc.what());
         }
         
-        // Cleanup CURL
-        curl_global_cleanup();
-        
     } 
     catch (const spdlog::spdlog_ex& ex) 
     {
         std::cout << "Log initialization failed: " << ex.what() << std::endl;
     }
     
+    // Cleanup CURL (after the sinks and their connection pools have been destroyed)
+    curl_global_cleanup();
+    
+    // Flush what the async loggers still hold
+    spdlog::shutdown();
+    
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+/**
+ * Wire encoding of the Sparkplug JSON document on the publishing side, PAYLOAD_ENCODING:
+ *   json     compact JSON (the default)
+ *   pretty   JSON indented by 4, what paho-pub used to send
+ *   cbor     RFC 8949 CBOR
+ *   msgpack  MessagePack
+ * All four carry the same document; paho-sub detects which one from the first byte.
+ */
+enum class PayloadEncoding {
+    Json,
+    PrettyJson,
+    Cbor,
+    MessagePack
+};
+
+inline bool payload_encoding_from_string(const std::string& name, PayloadEncoding& out) {
+    if (name == "json") {
+        out = PayloadEncoding::Json;
+    } else if (name == "pretty") {
+        out = PayloadEncoding::PrettyJson;
+    } else if (name == "cbor") {
+        out = PayloadEncoding::Cbor;
+    } else if (name == "msgpack") {
+        out = PayloadEncoding::MessagePack;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline const char* payload_encoding_name(PayloadEncoding encoding) {
+    switch (encoding) {
+    case PayloadEncoding::Json: return "json";
+    case PayloadEncoding::PrettyJson: return "pretty";
+    case PayloadEncoding::Cbor: return "cbor";
+    default: return "msgpack";
+    }
+}
+
+// PAYLOAD_ENCODING, compact JSON when unset or unknown
+inline PayloadEncoding payload_encoding_from_env() {
+    const char* value = std::getenv("PAYLOAD_ENCODING");
+    PayloadEncoding encoding = PayloadEncoding::Json;
+    if (value) {
+        payload_encoding_from_string(value, encoding);
+    }
+    return encoding;
+}
+
+inline std::string encode_payload(const nlohmann::json& doc, PayloadEncoding encoding) {
+    switch (encoding) {
+    case PayloadEncoding::PrettyJson:
+        return doc.dump(4);
+    case PayloadEncoding::Cbor: {
+        std::vector<uint8_t> bytes = nlohmann::json::to_cbor(doc);
+        return std::string(bytes.begin(), bytes.end());
+    }
+    case PayloadEncoding::MessagePack: {
+        std::vector<uint8_t> bytes = nlohmann::json::to_msgpack(doc);
+        return std::string(bytes.begin(), bytes.end());
+    }
+    default:
+        return doc.dump();
+    }
+}
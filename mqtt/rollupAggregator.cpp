@@ -0,0 +1,321 @@
+#include "rollupAggregator.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include "metrics.h"
+#include "subscriberConfig.h"
+
+namespace {
+
+// Rows per POST, so a flush after a long outage is not one huge request
+constexpr size_t ROWS_PER_POST = 5000;
+
+// A silent series with nothing open is forgotten after this (late samples would reopen buckets)
+constexpr int64_t FORGET_AFTER_MS = 2 * 3600 * 1000;
+
+int64_t wall_ms_now() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t floor_to(int64_t ts, int64_t width) {
+    int64_t rem = ts % width;
+    return rem < 0 ? ts - rem - width : ts - rem;
+}
+
+}  // namespace
+
+RollupOptions RollupOptions::from_env() {
+    RollupOptions o;
+    o.enabled = env_long("ROLLUPS", o.enabled ? 1 : 0) != 0;
+    o.flush_interval = std::chrono::milliseconds(
+        std::max(100L, env_long("ROLLUP_FLUSH_MS", (long)o.flush_interval.count())));
+    o.grace = std::chrono::milliseconds(std::max(0L, env_long("ROLLUP_GRACE_MS", (long)o.grace.count())));
+    o.max_pending_rows = (size_t)std::max(1000L, env_long("ROLLUP_MAX_PENDING_ROWS", (long)o.max_pending_rows));
+    return o;
+}
+
+const char* rollup_resolution_name(RollupResolution resolution) {
+    switch (resolution) {
+    case RollupResolution::Second: return "1s";
+    case RollupResolution::Minute: return "1m";
+    default: return "1h";
+    }
+}
+
+int64_t rollup_width_ms(RollupResolution resolution) {
+    switch (resolution) {
+    case RollupResolution::Second: return 1000;
+    case RollupResolution::Minute: return 60 * 1000;
+    default: return 3600 * 1000;
+    }
+}
+
+RollupAggregator::RollupAggregator(RollupOptions options) : options(options) {}
+
+void RollupAggregator::close(Series& series, size_t r, std::vector<RollupRow>& out) {
+    Bucket& bucket = series.open[r];
+    RollupRow row;
+    row.resolution = (RollupResolution)r;
+    row.bucket_start_ms = bucket.start_ms;
+    row.group_id = series.group_id;
+    row.node_id = series.node_id;
+    row.device_id = series.device_id;
+    row.metric = series.metric;
+    row.min = bucket.min;
+    row.max = bucket.max;
+    row.avg = bucket.sum / (double)bucket.count;
+    row.count = bucket.count;
+    row.last = bucket.last;
+    out.push_back(std::move(row));
+    series.closed_end[r] = bucket.start_ms + rollup_width_ms((RollupResolution)r);
+    bucket.count = 0;
+}
+
+void RollupAggregator::observe(const DecodedMessage& msg) {
+    const SparkplugTopic& topic = msg.topic;
+    if (!msg.ok || (topic.type != MessageType::DDATA && topic.type != MessageType::NDATA)) {
+        return;
+    }
+
+    std::string key;
+    key.reserve(topic.group_id.size() + topic.node_id.size() + 1);
+    key.append(topic.group_id);
+    key += '/';
+    key.append(topic.node_id);
+    Stripe& stripe = stripes[std::hash<std::string>{}(key) % STRIPES];
+
+    // "device|metric" of metrics without an index
+    std::string name_key;
+    name_key.append(topic.device_id);
+    name_key += '|';
+    const size_t prefix = name_key.size();
+
+    auto now = std::chrono::steady_clock::now();
+    // Only a missing timestamp falls back to the clock: pre-1970 ones are valid and floor_to() handles them
+    const int64_t wall_ms = msg.has_timestamp ? msg.timestamp_ms : wall_ms_now();
+    uint64_t samples = 0;
+    uint64_t late = 0;
+
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    NodeSeries& node = stripe.nodes[key];
+    for (const DecodedMetric& metric : msg.metrics) {
+        // Alias only metrics from a birth not seen have no name to store the rollup under
+        if (!metric.is_number() || metric.name.empty()) {
+            continue;
+        }
+        double value = metric.as_double();
+        if (!std::isfinite(value)) {
+            continue;
+        }
+        Series* found;
+        if (metric.has_index()) {
+            if (metric.index >= node.by_index.size()) {
+                node.by_index.resize(metric.index + 1);
+            }
+            found = &node.by_index[metric.index];
+        } else {
+            name_key.resize(prefix);
+            name_key.append(metric.name);
+            found = &node.by_name[name_key];
+        }
+        Series& series = *found;
+        if (!series.used) {
+            series.used = true;
+            series.group_id = std::string(topic.group_id);
+            series.node_id = std::string(topic.node_id);
+            series.device_id = std::string(topic.device_id);
+            series.metric = std::string(metric.name);
+        }
+        series.last_seen = now;
+        samples++;
+
+        const int64_t ts = metric.timestamp_ms != 0 ? metric.timestamp_ms : wall_ms;
+        bool was_late = false;
+        for (size_t r = 0; r < ROLLUP_RESOLUTIONS; ++r) {
+            const int64_t start = floor_to(ts, rollup_width_ms((RollupResolution)r));
+            Bucket& bucket = series.open[r];
+            if (start < series.closed_end[r] || (bucket.count > 0 && start < bucket.start_ms)) {
+                was_late = true;
+                continue;
+            }
+            if (bucket.count > 0 && start > bucket.start_ms) {
+                close(series, r, stripe.closed);
+            }
+            if (bucket.count == 0) {
+                bucket.start_ms = start;
+                bucket.min = value;
+                bucket.max = value;
+                bucket.sum = 0;
+                bucket.last_ms = ts;
+            }
+            bucket.count++;
+            bucket.min = std::min(bucket.min, value);
+            bucket.max = std::max(bucket.max, value);
+            bucket.sum += value;
+            if (ts >= bucket.last_ms) {
+                bucket.last = value;
+                bucket.last_ms = ts;
+            }
+        }
+        if (was_late) {
+            late++;
+        }
+    }
+
+    PipelineMetrics::RollupCounters& counters = pipeline_metrics().rollup;
+    counters.samples.fetch_add(samples, std::memory_order_relaxed);
+    counters.late.fetch_add(late, std::memory_order_relaxed);
+}
+
+bool RollupAggregator::collect_series(Series& series, std::chrono::steady_clock::time_point now, bool all,
+                                      std::vector<RollupRow>& out) const {
+    int64_t silent_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - series.last_seen).count();
+    bool open = false;
+    for (size_t r = 0; r < ROLLUP_RESOLUTIONS; ++r) {
+        if (series.open[r].count == 0) {
+            continue;
+        }
+        if (all || silent_ms >= rollup_width_ms((RollupResolution)r) + options.grace.count()) {
+            close(series, r, out);
+        } else {
+            open = true;
+        }
+    }
+    return open || silent_ms < FORGET_AFTER_MS;
+}
+
+void RollupAggregator::collect(std::vector<RollupRow>& rows, bool all) {
+    auto now = std::chrono::steady_clock::now();
+    for (Stripe& stripe : stripes) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        for (auto& entry : stripe.nodes) {
+            NodeSeries& node = entry.second;
+            for (Series& series : node.by_index) {
+                if (series.used && !collect_series(series, now, all, stripe.closed)) {
+                    series = Series();
+                }
+            }
+            for (auto it = node.by_name.begin(); it != node.by_name.end();) {
+                if (collect_series(it->second, now, all, stripe.closed)) {
+                    ++it;
+                } else {
+                    it = node.by_name.erase(it);
+                }
+            }
+        }
+        rows.insert(rows.end(), std::make_move_iterator(stripe.closed.begin()),
+                    std::make_move_iterator(stripe.closed.end()));
+        stripe.closed.clear();
+    }
+}
+
+size_t RollupAggregator::series() const {
+    size_t count = 0;
+    for (const Stripe& stripe : stripes) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        for (const auto& entry : stripe.nodes) {
+            count += entry.second.by_name.size();
+            for (const Series& series : entry.second.by_index) {
+                count += series.used ? 1 : 0;
+            }
+        }
+    }
+    return count;
+}
+
+RollupWriter::RollupWriter(RollupAggregator& aggregator, RollupOptions options, const std::string& fastapi_url,
+                           long timeout_ms)
+    : aggregator(aggregator), options(options), pool(fastapi_url, 1, timeout_ms) {
+    worker = std::thread(&RollupWriter::run, this);
+}
+
+RollupWriter::~RollupWriter() {
+    stop();
+}
+
+void RollupWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    flush(true);
+    if (!pending.empty()) {
+        spdlog::warn("Rollups: {} rows not written at shutdown", pending.size());
+    }
+}
+
+void RollupWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        wake.wait_for(lock, options.flush_interval, [this] { return !running; });
+        if (!running) {
+            break;
+        }
+        lock.unlock();
+        flush(false);
+        lock.lock();
+    }
+}
+
+std::string RollupWriter::build_body(const std::vector<RollupRow>& rows) {
+    nlohmann::json out = nlohmann::json::array();
+    for (const RollupRow& row : rows) {
+        out.push_back({
+            {"resolution", rollup_resolution_name(row.resolution)},
+            {"timestamp", row.bucket_start_ms},
+            {"group_id", row.group_id},
+            {"node_id", row.node_id},
+            {"device_id", row.device_id},
+            {"metric", row.metric},
+            {"min", row.min},
+            {"max", row.max},
+            {"avg", row.avg},
+            {"count", row.count},
+            {"last", row.last}
+        });
+    }
+    return nlohmann::json{{"rows", std::move(out)}}.dump();
+}
+
+void RollupWriter::flush(bool all) {
+    aggregator.collect(pending, all);
+    PipelineMetrics::RollupCounters& counters = pipeline_metrics().rollup;
+
+    size_t sent = 0;
+    std::vector<RollupRow> chunk;
+    while (sent < pending.size()) {
+        size_t end = std::min(pending.size(), sent + ROWS_PER_POST);
+        chunk.assign(std::make_move_iterator(pending.begin() + sent), std::make_move_iterator(pending.begin() + end));
+        CurlPool::Response res = pool.post("/ingest/rollup/bulk", build_body(chunk));
+        if (res.code != CURLE_OK || res.http_code < 200 || res.http_code >= 300) {
+            if (res.code != CURLE_OK) {
+                spdlog::error("Failed to send rollups to FastAPI: {}", curl_easy_strerror(res.code));
+            } else {
+                spdlog::error("FastAPI /ingest/rollup/bulk error (HTTP {}): {}", res.http_code, res.body);
+            }
+            // Put the chunk back and retry from here on the next flush
+            std::move(chunk.begin(), chunk.end(), pending.begin() + sent);
+            break;
+        }
+        counters.rows_written.fetch_add(chunk.size(), std::memory_order_relaxed);
+        sent = end;
+    }
+    pending.erase(pending.begin(), pending.begin() + sent);
+
+    if (pending.size() > options.max_pending_rows) {
+        size_t dropped = pending.size() - options.max_pending_rows;
+        pending.erase(pending.begin(), pending.begin() + dropped);
+        counters.rows_dropped.fetch_add(dropped, std::memory_order_relaxed);
+        spdlog::warn("Rollups: FastAPI unreachable, dropped the {} oldest rows", dropped);
+    }
+}
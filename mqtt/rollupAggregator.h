@@ -0,0 +1,155 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "curlPool.h"
+#include "decodedMessage.h"
+
+/**
+ * Rollup settings, from ROLLUPS (0/1), ROLLUP_FLUSH_MS (how often closed buckets are written),
+ * ROLLUP_GRACE_MS (how long after its end a bucket of a silent series is kept open for late
+ * samples) and ROLLUP_MAX_PENDING_ROWS (rows kept while FastAPI is unreachable).
+ * Not available with MQTT_SHARE_GROUP: the broker splits a node's data across the instances,
+ * so none of them sees every sample of a series.
+ */
+struct RollupOptions {
+    bool enabled = false;
+    std::chrono::milliseconds flush_interval{1000};
+    std::chrono::milliseconds grace{2000};
+    size_t max_pending_rows = 200000;
+
+    static RollupOptions from_env();
+};
+
+// Bucket widths, each written to its own table (rollup_1s, rollup_1m, rollup_1h)
+enum class RollupResolution { Second, Minute, Hour };
+
+constexpr size_t ROLLUP_RESOLUTIONS = 3;
+
+const char* rollup_resolution_name(RollupResolution resolution);
+int64_t rollup_width_ms(RollupResolution resolution);
+
+// One closed bucket of one series
+struct RollupRow {
+    RollupResolution resolution = RollupResolution::Second;
+    int64_t bucket_start_ms = 0;
+    std::string group_id;
+    std::string node_id;
+    std::string device_id;
+    std::string metric;
+    double min = 0;
+    double max = 0;
+    double avg = 0;
+    uint64_t count = 0;
+    double last = 0;
+};
+
+/**
+ * Incremental min/max/avg/count/last of every numeric DDATA/NDATA metric per
+ * (group, node, device, metric) series, in 1 s, 1 min and 1 h buckets of the metric's own
+ * Sparkplug timestamp. One hash lookup per message finds the node; its series are indexed by
+ * DecodedMetric::index (by name only when unindexed), so a sample costs three bucket updates.
+ *
+ * A bucket is closed when a sample of the same series falls into a later bucket, or by
+ * collect() once the series has been silent for the bucket width plus the grace period.
+ * Samples older than the last closed bucket of a resolution are counted as late and left out
+ * of it, so every bucket is written exactly once.
+ */
+class RollupAggregator {
+public:
+    explicit RollupAggregator(RollupOptions options);
+
+    RollupAggregator(const RollupAggregator&) = delete;
+    RollupAggregator& operator=(const RollupAggregator&) = delete;
+
+    void observe(const DecodedMessage& msg);
+
+    // Move the closed buckets to `rows`; with `all` every open bucket is closed too (shutdown)
+    void collect(std::vector<RollupRow>& rows, bool all = false);
+
+    size_t series() const;
+
+private:
+    struct Bucket {
+        int64_t start_ms = 0;
+        uint64_t count = 0;
+        double min = 0;
+        double max = 0;
+        double sum = 0;
+        double last = 0;
+        int64_t last_ms = 0;
+    };
+
+    struct Series {
+        bool used = false;
+        std::string group_id;
+        std::string node_id;
+        std::string device_id;
+        std::string metric;
+        std::array<Bucket, ROLLUP_RESOLUTIONS> open;
+        std::array<int64_t, ROLLUP_RESOLUTIONS> closed_end{      // End of the last closed bucket, none yet
+            INT64_MIN, INT64_MIN, INT64_MIN};
+        std::chrono::steady_clock::time_point last_seen;
+    };
+
+    struct NodeSeries {
+        std::vector<Series> by_index;                       // DecodedMetric::index
+        std::unordered_map<std::string, Series> by_name;    // "device|metric" of unindexed metrics
+    };
+
+    struct Stripe {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, NodeSeries> nodes;  // "group/node"
+        std::vector<RollupRow> closed;
+    };
+
+    static constexpr size_t STRIPES = 16;
+
+    static void close(Series& series, size_t r, std::vector<RollupRow>& out);
+    // Close what is due; false when the series has nothing open and was silent long enough to forget
+    bool collect_series(Series& series, std::chrono::steady_clock::time_point now, bool all,
+                        std::vector<RollupRow>& out) const;
+
+    RollupOptions options;
+    std::array<Stripe, STRIPES> stripes;
+};
+
+/**
+ * Writes the closed buckets every flush_interval as one POST to FastAPI's /ingest/rollup/bulk,
+ * on its own thread. Rows that could not be delivered are retried on the next flush, up to
+ * max_pending_rows (the oldest are dropped beyond that).
+ */
+class RollupWriter {
+public:
+    RollupWriter(RollupAggregator& aggregator, RollupOptions options, const std::string& fastapi_url,
+                 long timeout_ms);
+    ~RollupWriter();
+
+    RollupWriter(const RollupWriter&) = delete;
+    RollupWriter& operator=(const RollupWriter&) = delete;
+
+    // Close every open bucket, write what is left, then stop the thread
+    void stop();
+
+    static std::string build_body(const std::vector<RollupRow>& rows);
+
+private:
+    void run();
+    void flush(bool all);
+
+    RollupAggregator& aggregator;
+    RollupOptions options;
+    CurlPool pool;
+    std::vector<RollupRow> pending;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool running = true;
+    std::thread worker;
+};
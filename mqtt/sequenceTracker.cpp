@@ -0,0 +1,144 @@
+#include "sequenceTracker.h"
+#include <algorithm>
+#include <functional>
+#include "metrics.h"
+
+namespace {
+
+int64_t bd_seq_of(const DecodedMessage& msg) {
+    for (const DecodedMetric& metric : msg.metrics) {
+        if (metric.name == "bdSeq" && metric.is_number()) {
+            return metric.as_int64();
+        }
+    }
+    return -1;
+}
+
+}  // namespace
+
+const char* seq_verdict_name(SeqVerdict verdict) {
+    switch (verdict) {
+    case SeqVerdict::InOrder: return "in-order";
+    case SeqVerdict::Gap: return "gap";
+    case SeqVerdict::Late: return "late";
+    case SeqVerdict::Duplicate: return "duplicate";
+    case SeqVerdict::OutOfWindow: return "out-of-window";
+    default: return "no-birth";
+    }
+}
+
+SeqVerdict SequenceTracker::advance(NodeState& state, uint8_t seq) {
+    // Distance from the highest seq, as a signed step on the 0-255 ring
+    int delta = (int8_t)(uint8_t)(seq - state.highest);
+    PipelineMetrics::SequenceCounters& counters = pipeline_metrics().sequence;
+    if (delta == 0) {
+        return SeqVerdict::Duplicate;
+    }
+    if (delta > 0) {
+        state.window = delta >= 64 ? 1 : (state.window << delta) | 1;
+        state.span = (uint8_t)std::min(64, state.span + delta);
+        state.highest = seq;
+        if (delta == 1) {
+            return SeqVerdict::InOrder;
+        }
+        counters.missing.fetch_add(delta - 1, std::memory_order_relaxed);
+        counters.gaps.fetch_add(1, std::memory_order_relaxed);
+        return SeqVerdict::Gap;
+    }
+    int behind = -delta;
+    // Only seqs since the NBIRTH are in the window, anything older is a stray from a past session
+    if (behind >= state.span) {
+        counters.out_of_window.fetch_add(1, std::memory_order_relaxed);
+        return SeqVerdict::OutOfWindow;
+    }
+    uint64_t bit = 1ULL << behind;
+    if (state.window & bit) {
+        return SeqVerdict::Duplicate;
+    }
+    state.window |= bit;
+    // It was counted missing when the gap opened
+    counters.late.fetch_add(1, std::memory_order_relaxed);
+    counters.missing.fetch_sub(1, std::memory_order_relaxed);
+    return SeqVerdict::Late;
+}
+
+SeqVerdict SequenceTracker::check(const DecodedMessage& msg) {
+    const SparkplugTopic& topic = msg.topic;
+    MessageType type = topic.type;
+    bool sequenced = type == MessageType::NBIRTH || type == MessageType::NDATA || type == MessageType::DBIRTH ||
+                     type == MessageType::DDATA || type == MessageType::DDEATH;
+    if (!msg.ok || (!sequenced && type != MessageType::NDEATH)) {
+        return SeqVerdict::InOrder;
+    }
+
+    std::string key;
+    key.reserve(topic.group_id.size() + topic.node_id.size() + 1);
+    key.append(topic.group_id);
+    key += '/';
+    key.append(topic.node_id);
+
+    Stripe& stripe = stripes[std::hash<std::string>{}(key) % STRIPES];
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    PipelineMetrics::SequenceCounters& counters = pipeline_metrics().sequence;
+    SeqVerdict verdict;
+
+    if (type == MessageType::NBIRTH) {
+        NodeState& state = stripe.nodes[key];
+        int64_t bd_seq = bd_seq_of(msg);
+        size_t birth_hash = std::hash<std::string_view>{}(msg.payload);
+        // Timestamps are in whole seconds on some nodes and bdSeq may repeat after a restart, so only
+        // the very same payload (seq and metric values included) is the broker delivering it again
+        if (state.alive && bd_seq == state.bd_seq && msg.timestamp_ms == state.birth_timestamp_ms &&
+            birth_hash == state.birth_hash) {
+            verdict = SeqVerdict::Duplicate;
+        } else {
+            state.highest = (uint8_t)(msg.has_seq ? msg.seq : 0);
+            state.window = 1;
+            state.span = 1;
+            state.bd_seq = bd_seq;
+            state.birth_timestamp_ms = msg.timestamp_ms;
+            state.birth_hash = birth_hash;
+            state.alive = true;
+            verdict = SeqVerdict::InOrder;
+        }
+    } else {
+        auto it = stripe.nodes.find(key);
+        if (it == stripe.nodes.end() || !it->second.alive) {
+            counters.no_birth.fetch_add(1, std::memory_order_relaxed);
+            return SeqVerdict::NoBirth;
+        }
+        NodeState& state = it->second;
+        if (type == MessageType::NDEATH) {
+            // NDEATH is the broker's will message: no seq, only the bdSeq of the birth it ends.
+            // One of an earlier session (delivered after the rebirth) leaves the current one alive.
+            int64_t bd_seq = bd_seq_of(msg);
+            if (bd_seq >= 0 && state.bd_seq >= 0 && bd_seq != state.bd_seq) {
+                counters.bd_seq_mismatch.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                state.alive = false;
+            }
+            verdict = SeqVerdict::InOrder;
+        } else if (!msg.has_seq) {
+            verdict = SeqVerdict::InOrder;
+        } else {
+            verdict = advance(state, (uint8_t)msg.seq);
+        }
+        if (msg.has_timestamp && verdict != SeqVerdict::Duplicate) {
+            state.last_timestamp_ms = std::max(state.last_timestamp_ms, msg.timestamp_ms);
+        }
+    }
+
+    if (verdict == SeqVerdict::Duplicate) {
+        counters.duplicates.fetch_add(1, std::memory_order_relaxed);
+    }
+    return verdict;
+}
+
+size_t SequenceTracker::nodes() const {
+    size_t count = 0;
+    for (const Stripe& stripe : stripes) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        count += stripe.nodes.size();
+    }
+    return count;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "decodedMessage.h"
+
+/**
+ * What the sequence tracker made of a message
+ */
+enum class SeqVerdict {
+    InOrder,       // The next seq (or a message without seq tracking: commands, STATE)
+    Gap,           // Ahead of the next seq: the ones in between are missing (for now)
+    Late,          // Behind, fills a gap inside the window
+    Duplicate,     // Seen before: QoS 1 redelivery or a publisher retry, do not store again
+    OutOfWindow,   // Too far behind to tell, passed on
+    NoBirth        // Data from a node whose NBIRTH this process has not seen
+};
+
+const char* seq_verdict_name(SeqVerdict verdict);
+
+/**
+ * Per-node Sparkplug B sequence state, O(1) per message.
+ *
+ * Every message of an edge node (NBIRTH, NDATA, DBIRTH, DDATA, ...) carries seq 0-255,
+ * wrapping, and NBIRTH restarts it at 0. Per node we keep the highest seq seen and a 64 bit
+ * bitmap of which of the 64 seqs up to it arrived, so a message is a duplicate, a late
+ * arrival filling a gap or a gap itself after one shift and one bit test. bdSeq and the
+ * last payload timestamp are kept as well: a repeated NBIRTH (same bdSeq and timestamp) is
+ * a duplicate. An NDEATH ends the node's session only when its bdSeq matches the current
+ * birth (or either is unknown); a stale one from an earlier session is counted and ignored.
+ *
+ * The table is split into lock stripes by node, so ingest workers rarely contend.
+ */
+class SequenceTracker {
+public:
+    SeqVerdict check(const DecodedMessage& msg);
+
+    size_t nodes() const;
+
+private:
+    struct NodeState {
+        uint8_t highest = 0;         // Highest seq seen (mod 256)
+        uint64_t window = 0;         // Bit i: seq (highest - i) was seen
+        uint8_t span = 0;            // Window bits that lie after the NBIRTH (at most 64)
+        int64_t bd_seq = -1;         // From the last NBIRTH, -1 when unknown
+        int64_t birth_timestamp_ms = 0;
+        size_t birth_hash = 0;       // Of the NBIRTH payload, tells a redelivery from a quick restart
+        int64_t last_timestamp_ms = 0;
+        bool alive = false;
+    };
+
+    struct Stripe {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, NodeState> nodes;
+    };
+
+    static constexpr size_t STRIPES = 16;
+
+    static SeqVerdict advance(NodeState& state, uint8_t seq);
+
+    std::array<Stripe, STRIPES> stripes;
+};
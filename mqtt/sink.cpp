@@ -0,0 +1,434 @@
+#include "sink.h"
+#include "subscriberConfig.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+SinkPolicy SinkPolicy::from_env(const std::string& prefix, SinkPolicy defaults) {
+    SinkPolicy p = defaults;
+    auto var = [&prefix](const char* suffix) { return prefix + "_" + suffix; };
+
+    p.batch_max_messages = (size_t)std::max(1L, env_long(var("BATCH_MAX_MESSAGES").c_str(), (long)p.batch_max_messages));
+    p.batch_max_bytes = (size_t)std::max(1L, env_long(var("BATCH_MAX_BYTES").c_str(), (long)p.batch_max_bytes));
+    p.batch_max_latency = std::chrono::milliseconds(
+        std::max(0L, env_long(var("BATCH_MAX_LATENCY_MS").c_str(), (long)p.batch_max_latency.count())));
+    p.max_retries = (int)std::max(0L, env_long(var("MAX_RETRIES").c_str(), p.max_retries));
+    p.retry_backoff = std::chrono::milliseconds(
+        std::max(1L, env_long(var("RETRY_BACKOFF_MS").c_str(), (long)p.retry_backoff.count())));
+    p.queue_capacity = (size_t)std::max(2L, env_long(var("QUEUE_CAPACITY").c_str(), (long)p.queue_capacity));
+    p.overflow = overflow_policy_from_string(env_string(var("OVERFLOW").c_str(), overflow_policy_name(p.overflow)));
+    return p;
+}
+
+SinkRunner::SinkRunner(std::unique_ptr<Sink> sink, SinkPolicy policy, std::unique_ptr<Spool> spool)
+    : sink(std::move(sink)), policy(policy), queue(policy.queue_capacity, policy.overflow), spool(std::move(spool)) {
+    sink_name = this->sink->name();
+    metrics = &pipeline_metrics().sink(sink_name);
+    if (this->spool && !this->spool->usable()) {
+        spdlog::error("Sink {} runs without spool, undeliverable batches will be dropped", sink_name);
+        this->spool.reset();
+    }
+    if (this->spool) {
+        replay_max_per_sec = this->spool->config().replay_max_per_sec;
+        replay_max_attempts = this->spool->config().replay_max_attempts;
+        spool_max_bytes = std::max<uint64_t>(1, this->spool->config().max_bytes);
+    }
+    replay_backoff = policy.retry_backoff;
+    last_refill = std::chrono::steady_clock::now();
+    worker = std::thread([this] { run(); });
+}
+
+SinkRunner::~SinkRunner() {
+    stop();
+}
+
+void SinkRunner::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    queue.close();
+    worker.join();
+}
+
+void SinkRunner::run() {
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<SinkMessagePtr> batch;
+    batch.reserve(policy.batch_max_messages);
+    size_t batch_bytes = 0;
+    Clock::time_point batch_started;
+    SinkMessagePtr msg;
+    SinkMessagePtr held;    // Needs a batch of its own, waits for the current one to go out
+
+    while (running.load(std::memory_order_acquire) || queue.depth() > 0 || !batch.empty() || held) {
+        size_t scale = batch_scale.load(std::memory_order_relaxed);
+        size_t max_messages = policy.batch_max_messages * scale;
+        size_t max_bytes = policy.batch_max_bytes * scale;
+        auto max_latency = policy.batch_max_latency * (long)scale;
+
+        // Sleep no longer than until the current batch is due (or the spool wants replaying)
+        auto wait = std::chrono::milliseconds(100);
+        if (spool && !spool->empty()) {
+            wait = std::chrono::milliseconds(10);
+        }
+        if (!batch.empty()) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                batch_started + max_latency - Clock::now());
+            wait = std::max(std::chrono::milliseconds(0), std::min(wait, left));
+        }
+
+        bool got;
+        if (held) {
+            msg = std::move(held);
+            got = true;
+        } else {
+            got = wait.count() > 0 ? queue.pop_wait(msg, wait) : queue.try_pop(msg);
+        }
+        bool cut = false;
+        while (got) {
+            bool alone = sink->needs_own_batch(*msg);
+            if (alone && !batch.empty()) {
+                held = std::move(msg);
+                cut = true;
+                break;
+            }
+            if (batch.empty()) {
+                batch_started = Clock::now();
+            }
+            batch_bytes += msg->payload.size();
+            batch.push_back(std::move(msg));
+            if (alone || batch.size() >= max_messages || batch_bytes >= max_bytes) {
+                cut = cut || alone;
+                break;
+            }
+            got = queue.try_pop(msg);
+        }
+
+        if (!batch.empty()) {
+            bool due = cut || batch.size() >= max_messages || batch_bytes >= max_bytes ||
+                       Clock::now() >= batch_started + max_latency ||
+                       !running.load(std::memory_order_acquire);
+            if (due) {
+                dispatch(batch);
+                batch.clear();
+                batch_bytes = 0;
+            }
+        }
+
+        if (spool) {
+            replay();
+            spool->maybe_sync();
+            release_synced();
+            spool_pending = spool->pending();
+            spool_bytes = spool->bytes_on_disk();
+            spool_evicted = spool->stats().evicted_records;
+        }
+    }
+
+    if (spool) {
+        spool->sync();
+        release_synced();
+    }
+}
+
+void SinkRunner::dispatch(std::vector<SinkMessagePtr>& batch) {
+    // Behind a backlog: queue up on disk so the sink sees messages in order
+    if (spool && !spool->empty()) {
+        to_spool(batch);
+        return;
+    }
+    WriteResult result = deliver(batch);
+    if (result == WriteResult::Ok) {
+        return;
+    }
+    if (result == WriteResult::Reject) {
+        dead_letter(batch, "rejected by the sink");
+        return;
+    }
+    if (spool) {
+        to_spool(batch);
+        next_replay = std::chrono::steady_clock::now() + replay_backoff;
+    } else {
+        failed += batch.size();
+        metrics->failed.fetch_add(batch.size(), std::memory_order_relaxed);
+        spdlog::error("Sink {} gave up on {} messages after {} retries", sink_name, batch.size(), policy.max_retries);
+    }
+}
+
+WriteResult SinkRunner::deliver(std::vector<SinkMessagePtr>& batch) {
+    auto backoff = policy.retry_backoff;
+    for (int attempt = 0; attempt <= policy.max_retries; ++attempt) {
+        if (attempt > 0) {
+            retries++;
+            std::this_thread::sleep_for(backoff);
+            backoff = std::min(backoff * 2, std::chrono::milliseconds(10000));
+        }
+
+        WriteResult result = WriteResult::Retry;
+        auto started = std::chrono::steady_clock::now();
+        try {
+            result = sink->write_batch(batch);
+        } catch (const std::exception& e) {
+            spdlog::error("Sink {} threw while writing {} messages: {}", sink_name, batch.size(), e.what());
+        }
+        auto now = std::chrono::steady_clock::now();
+        metrics->write.record(now - started);
+        if (result == WriteResult::Reject) {
+            return result;
+        }
+        if (result == WriteResult::Ok) {
+            for (const auto& m : batch) {
+                latency.record(now - m->arrived);
+                metrics->end_to_end.record(now - m->arrived);
+            }
+            metrics->delivered.fetch_add(batch.size(), std::memory_order_relaxed);
+            delivered += batch.size();
+            batches++;
+            return result;
+        }
+    }
+    return WriteResult::Retry;
+}
+
+void SinkRunner::to_spool(const std::vector<SinkMessagePtr>& batch) {
+    encode_spool_record(batch, spool_buffer);
+    if (spool->append(spool_buffer)) {
+        spooled += batch.size();
+        // Held until the record is on disk, not only in the page cache, so the window covers the sync
+        for (const auto& m : batch) {
+            if (m->ack) {
+                unsynced_acks.push_back(m->ack);
+            }
+        }
+        release_synced();
+    } else {
+        failed += batch.size();
+        metrics->failed.fetch_add(batch.size(), std::memory_order_relaxed);
+        spdlog::error("Sink {} could not spool {} messages, dropped", sink_name, batch.size());
+    }
+}
+
+void SinkRunner::release_synced() {
+    if (spool->synced()) {
+        unsynced_acks.clear();
+    }
+}
+
+void SinkRunner::dead_letter(const std::vector<SinkMessagePtr>& batch, const std::string& reason) {
+    dead_lettered += batch.size();
+    metrics->dead_lettered.fetch_add(batch.size(), std::memory_order_relaxed);
+    if (!spool) {
+        spdlog::error("Sink {} dropped {} messages: {}", sink_name, batch.size(), reason);
+        return;
+    }
+
+    // One JSON line per message next to the spool segments, for inspection or a manual re-send
+    std::string path = spool->directory() + "/dead-letter.jsonl";
+    FILE* f = std::fopen(path.c_str(), "ab");
+    if (!f) {
+        spdlog::error("Sink {} dropped {} messages ({}), cannot open {}: {}", sink_name, batch.size(), reason, path,
+                      std::strerror(errno));
+        return;
+    }
+    std::string line;
+    std::string scratch;
+    for (const auto& msg : batch) {
+        line = "{\"reason\":" + nlohmann::json(reason).dump();
+        line += ",\"topic\":" + nlohmann::json(std::string(msg->topic.topic)).dump();
+        line += ",\"payload\":";
+        if (msg->ok) {
+            std::string_view json = msg->as_json(scratch);
+            // Keep one message per line; raw newlines can only be insignificant whitespace in valid JSON
+            size_t start = line.size();
+            line.append(json);
+            std::replace(line.begin() + start, line.end(), '\n', ' ');
+            std::replace(line.begin() + start, line.end(), '\r', ' ');
+        } else {
+            line += "null";
+        }
+        line += "}\n";
+        std::fwrite(line.data(), 1, line.size(), f);
+    }
+    std::fclose(f);
+    spdlog::error("Sink {} dead-lettered {} messages to {}: {}", sink_name, batch.size(), path, reason);
+}
+
+void SinkRunner::replay() {
+    using Clock = std::chrono::steady_clock;
+    if (spool->empty() || !running.load(std::memory_order_acquire)) {
+        return;
+    }
+    auto now = Clock::now();
+    if (now < next_replay) {
+        return;
+    }
+
+    // Token bucket over messages, at most one second of burst
+    long rate = replay_max_per_sec;
+    if (rate > 0) {
+        double elapsed = std::chrono::duration<double>(now - last_refill).count();
+        replay_tokens = std::min((double)rate, replay_tokens + elapsed * rate);
+    }
+    last_refill = now;
+
+    // Bounded slice, so the live queue keeps being drained meanwhile
+    auto slice_end = now + std::chrono::milliseconds(50);
+    std::string_view record;
+    std::vector<SinkMessagePtr> records;
+    while (Clock::now() < slice_end && (rate == 0 || replay_tokens > 0) && spool->peek(record)) {
+        records.clear();
+        if (!decode_spool_record(record, records)) {
+            spdlog::error("Sink {}: unreadable spool record skipped", sink_name);
+            spool->ack();
+            continue;
+        }
+
+        WriteResult result = WriteResult::Retry;
+        try {
+            result = sink->write_batch(records);
+        } catch (const std::exception& e) {
+            spdlog::error("Sink {} threw while replaying {} messages: {}", sink_name, records.size(), e.what());
+        }
+        if (result == WriteResult::Reject) {
+            dead_letter(records, "rejected by the sink");
+            spool->ack();
+            replay_attempts = 0;
+            continue;
+        }
+        if (result != WriteResult::Ok) {
+            if (replay_max_attempts > 0 && ++replay_attempts >= replay_max_attempts) {
+                dead_letter(records, "still rejected after " + std::to_string(replay_attempts) + " replay attempts");
+                spool->ack();
+                replay_attempts = 0;
+            }
+            // Still down: probe again later, backing off like deliver() does
+            next_replay = Clock::now() + replay_backoff;
+            replay_backoff = std::min(replay_backoff * 2, std::chrono::milliseconds(10000));
+            return;
+        }
+        spool->ack();
+        replay_attempts = 0;
+        replayed += records.size();
+        replay_tokens -= (double)records.size();
+        replay_backoff = policy.retry_backoff;
+    }
+}
+
+void SinkRunner::log_stats() {
+    LatencyStats::Summary s = latency.take();
+    uint64_t b = batches.exchange(0);
+    uint64_t d = delivered.exchange(0);
+    const QueueCounters& q = queue.stats();
+    spdlog::info("Sink {} - delivered: {}, failed: {}, batches: {}, avg batch: {:.1f}, retries: {}, "
+                 "queue depth: {}, dropped: {}, latency p50: {:.2f} ms, p99: {:.2f} ms, max: {:.2f} ms",
+                 sink_name, d, failed.exchange(0), b, b ? (double)d / b : 0.0, retries.exchange(0),
+                 queue.depth(), q.dropped_oldest.load() + q.dropped_newest.load(),
+                 s.p50_ms, s.p99_ms, s.max_ms);
+    if (spool) {
+        spdlog::info("Sink {} spool - spooled: {}, replayed: {}, dead-lettered: {}, pending: {}, on disk: {} bytes, "
+                     "evicted total: {}", sink_name, spooled.exchange(0), replayed.exchange(0),
+                     dead_lettered.exchange(0), spool_pending.load(), spool_bytes.load(), spool_evicted.load());
+    }
+}
+
+void SinkFanOut::add(std::unique_ptr<Sink> sink, SinkPolicy policy, std::unique_ptr<Spool> spool) {
+    runners.emplace_back(new SinkRunner(std::move(sink), policy, std::move(spool)));
+}
+
+void SinkFanOut::publish(const SinkMessagePtr& msg) {
+    for (auto& runner : runners) {
+        runner->submit(msg);
+    }
+}
+
+void SinkFanOut::stop() {
+    for (auto& runner : runners) {
+        runner->stop();
+    }
+}
+
+void SinkFanOut::log_stats() {
+    for (auto& runner : runners) {
+        runner->log_stats();
+    }
+}
+
+std::vector<std::string> SinkFanOut::names() const {
+    std::vector<std::string> result;
+    for (const auto& runner : runners) {
+        result.push_back(runner->name());
+    }
+    return result;
+}
+
+std::vector<std::pair<std::string, size_t>> SinkFanOut::queue_depths() const {
+    std::vector<std::pair<std::string, size_t>> result;
+    for (const auto& runner : runners) {
+        result.emplace_back(runner->name(), runner->queue_depth());
+    }
+    return result;
+}
+
+std::vector<SinkLoad> SinkFanOut::loads() const {
+    std::vector<SinkLoad> result;
+    for (const auto& runner : runners) {
+        result.push_back(SinkLoad{runner->name(), runner->queue_fill(), runner->spool_fill()});
+    }
+    return result;
+}
+
+void SinkFanOut::set_batch_scale(size_t scale) {
+    for (auto& runner : runners) {
+        runner->set_batch_scale(scale);
+    }
+}
+
+namespace {
+template <typename T>
+void put(std::string& out, T value) {
+    out.append((const char*)&value, sizeof(T));
+}
+
+template <typename T>
+bool get(std::string_view& in, T& value) {
+    if (in.size() < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, in.data(), sizeof(T));
+    in.remove_prefix(sizeof(T));
+    return true;
+}
+}
+
+void encode_spool_record(const std::vector<SinkMessagePtr>& batch, std::string& out) {
+    out.clear();
+    put<uint32_t>(out, (uint32_t)batch.size());
+    for (const auto& m : batch) {
+        put<uint32_t>(out, (uint32_t)m->topic.topic.size());
+        put<uint32_t>(out, (uint32_t)m->payload.size());
+        out.append(m->topic.topic.data(), m->topic.topic.size());
+        out.append(m->payload.data(), m->payload.size());
+    }
+}
+
+bool decode_spool_record(std::string_view record, std::vector<SinkMessagePtr>& batch) {
+    uint32_t count;
+    if (!get(record, count)) {
+        return false;
+    }
+    auto now = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t topic_len, payload_len;
+        if (!get(record, topic_len) || !get(record, payload_len) ||
+            record.size() < (size_t)topic_len + payload_len) {
+            return false;
+        }
+        std::string topic(record.substr(0, topic_len));
+        std::string payload(record.substr(topic_len, payload_len));
+        record.remove_prefix((size_t)topic_len + payload_len);
+        batch.push_back(DecodedMessage::decode(std::move(topic), std::move(payload), now));
+    }
+    return true;
+}
@@ -0,0 +1,171 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ingestQueue.h"
+#include "latencyStats.h"
+#include "metrics.h"
+#include "decodedMessage.h"
+#include "spool.h"
+
+// Sinks get the same decoded message security analysis used, shared read-only
+using SinkMessagePtr = DecodedMessage::Ptr;
+
+// Outcome of one write_batch() call
+enum class WriteResult {
+    Ok,         // The destination accepted the whole batch
+    Retry,      // Transient (unreachable, overloaded...): retried, then spooled
+    Reject,     // The destination refused the data itself; dead-lettered, never retried
+};
+
+/**
+ * Destination for Sparkplug messages (FastAPI, QuestDB ILP, file...).
+ * write_batch() is only ever called from the sink's own SinkRunner thread.
+ */
+class Sink {
+public:
+    virtual ~Sink() = default;
+    virtual std::string name() const = 0;
+
+    // Deliver a whole batch
+    virtual WriteResult write_batch(const std::vector<SinkMessagePtr>& batch) = 0;
+
+    /**
+     * true for messages the sink writes with a request of their own: SinkRunner then hands them
+     * over alone, so a retried or replayed batch never repeats a part that already went through
+     */
+    virtual bool needs_own_batch(const DecodedMessage&) const { return false; }
+};
+
+/**
+ * Batching and retry settings of one sink.
+ * Read from <PREFIX>_BATCH_MAX_MESSAGES, <PREFIX>_BATCH_MAX_BYTES, <PREFIX>_BATCH_MAX_LATENCY_MS,
+ * <PREFIX>_MAX_RETRIES, <PREFIX>_RETRY_BACKOFF_MS, <PREFIX>_QUEUE_CAPACITY and <PREFIX>_OVERFLOW.
+ */
+struct SinkPolicy {
+    size_t batch_max_messages = 500;
+    size_t batch_max_bytes = 512 * 1024;
+    std::chrono::milliseconds batch_max_latency{200};
+    int max_retries = 3;
+    std::chrono::milliseconds retry_backoff{100};      // Doubled on every retry
+    size_t queue_capacity = 16384;
+    OverflowPolicy overflow = OverflowPolicy::Block;
+
+    static SinkPolicy from_env(const std::string& prefix, SinkPolicy defaults);
+};
+
+/**
+ * Runs one sink on its own thread with its own queue, batching and retries,
+ * so a slow destination never delays the others. Messages the sink needs_own_batch() for
+ * close the batch before them and are dispatched alone, in order.
+ *
+ * With a spool, batches that still fail after the retries are written to disk instead of
+ * being dropped. While the spool holds a backlog, new batches are appended behind it (so
+ * order is kept) and the backlog is replayed, rate limited, as soon as the sink accepts
+ * writes again. A record that still fails after replay_max_attempts is dead-lettered, so one
+ * bad record cannot hold up the backlog behind it. Batches the sink rejects outright are
+ * dead-lettered at once, live or replayed.
+ *
+ * Messages carrying an AckGate ticket (QoS 1) keep it until the sink accepted them, the spool
+ * synced them or they were given up on.
+ */
+class SinkRunner {
+public:
+    SinkRunner(std::unique_ptr<Sink> sink, SinkPolicy policy, std::unique_ptr<Spool> spool = nullptr);
+    ~SinkRunner();
+
+    bool submit(SinkMessagePtr msg) { return queue.push(std::move(msg)); }
+
+    // Deliver what is queued, then stop the thread
+    void stop();
+
+    void log_stats();
+    const std::string& name() const { return sink_name; }
+    size_t queue_depth() const { return queue.depth(); }
+    double queue_fill() const { return (double)queue.depth() / (double)queue.capacity(); }
+    // Share of SPOOL_MAX_BYTES in use, -1 without a spool
+    double spool_fill() const {
+        return spool_max_bytes ? (double)spool_bytes.load(std::memory_order_relaxed) / (double)spool_max_bytes : -1.0;
+    }
+
+    // Multiply the batch limits (messages, bytes, latency), so a slow sink gets fewer, bigger writes
+    void set_batch_scale(size_t scale) { batch_scale.store(scale ? scale : 1, std::memory_order_relaxed); }
+
+private:
+    void run();
+    void dispatch(std::vector<SinkMessagePtr>& batch);
+    WriteResult deliver(std::vector<SinkMessagePtr>& batch);
+    void to_spool(const std::vector<SinkMessagePtr>& batch);
+    void release_synced();
+    void dead_letter(const std::vector<SinkMessagePtr>& batch, const std::string& reason);
+    void replay();
+
+    std::unique_ptr<Sink> sink;
+    std::string sink_name;
+    SinkPolicy policy;
+    MpscQueue<SinkMessagePtr> queue;
+
+    std::unique_ptr<Spool> spool;
+    std::string spool_buffer;
+    std::vector<AckGate::Ticket> unsynced_acks;     // Of spooled messages, until the next sync
+    uint64_t spool_max_bytes = 0;                   // 0 = no spool
+    std::chrono::steady_clock::time_point next_replay;
+    std::chrono::steady_clock::time_point last_refill;
+    std::chrono::milliseconds replay_backoff;
+    double replay_tokens = 0;
+    long replay_max_per_sec = 0;
+    int replay_max_attempts = 0;
+    int replay_attempts = 0;                        // Of the record at the head of the spool
+    std::atomic<uint64_t> spooled{0};
+    std::atomic<uint64_t> replayed{0};
+    // Spool state published by the runner thread for log_stats()
+    std::atomic<uint64_t> spool_pending{0};
+    std::atomic<uint64_t> spool_bytes{0};
+    std::atomic<uint64_t> spool_evicted{0};
+    std::atomic<uint64_t> dead_lettered{0};
+
+    LatencyStats latency;
+    PipelineMetrics::SinkMetrics* metrics;
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> retries{0};
+
+    std::atomic<size_t> batch_scale{1};
+    std::atomic<bool> running{true};
+    std::thread worker;
+};
+
+// How far one sink is behind, for the load controller
+struct SinkLoad {
+    std::string name;
+    double queue_fill = 0;
+    double spool_fill = -1;     // < 0: no spool
+};
+
+/**
+ * Hands every message to all configured sinks.
+ */
+class SinkFanOut {
+public:
+    void add(std::unique_ptr<Sink> sink, SinkPolicy policy, std::unique_ptr<Spool> spool = nullptr);
+    void publish(const SinkMessagePtr& msg);
+    void stop();
+    void log_stats();
+
+    bool empty() const { return runners.empty(); }
+    std::vector<std::string> names() const;
+    std::vector<std::pair<std::string, size_t>> queue_depths() const;
+    std::vector<SinkLoad> loads() const;
+    void set_batch_scale(size_t scale);
+
+private:
+    std::vector<std::unique_ptr<SinkRunner>> runners;
+};
+
+// Spool record format of a batch: count, then per message topic and raw payload
+void encode_spool_record(const std::vector<SinkMessagePtr>& batch, std::string& out);
+bool decode_spool_record(std::string_view record, std::vector<SinkMessagePtr>& batch);
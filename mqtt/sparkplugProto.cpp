@@ -0,0 +1,375 @@
+#include "sparkplugProto.h"
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+// Protobuf wire types
+constexpr uint32_t WIRE_VARINT = 0;
+constexpr uint32_t WIRE_FIXED64 = 1;
+constexpr uint32_t WIRE_LEN = 2;
+constexpr uint32_t WIRE_FIXED32 = 5;
+
+const std::string_view DATATYPE_NAMES[] = {
+    "", "Int8", "Int16", "Int32", "Int64", "UInt8", "UInt16", "UInt32", "UInt64",
+    "Float", "Double", "Boolean", "String", "DateTime", "Text", "UUID", "DataSet",
+    "Bytes", "File", "Template",
+};
+
+/**
+ * Bounds checked reader over protobuf wire format
+ */
+class ProtoReader {
+public:
+    explicit ProtoReader(std::string_view bytes)
+        : p((const uint8_t*)bytes.data()), end((const uint8_t*)bytes.data() + bytes.size()) {}
+
+    bool done() const { return p == end; }
+
+    bool varint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && p != end; shift += 7) {
+            uint8_t b = *p++;
+            value |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool tag(uint32_t& field, uint32_t& wire) {
+        uint64_t key;
+        if (!varint(key) || (key >> 3) == 0 || (key >> 3) > UINT32_MAX) {
+            return false;
+        }
+        field = (uint32_t)(key >> 3);
+        wire = (uint32_t)(key & 7);
+        return true;
+    }
+
+    bool fixed32(uint32_t& value) {
+        if (end - p < 4) {
+            return false;
+        }
+        std::memcpy(&value, p, 4);    // Little endian on the wire and on our targets
+        p += 4;
+        return true;
+    }
+
+    bool fixed64(uint64_t& value) {
+        if (end - p < 8) {
+            return false;
+        }
+        std::memcpy(&value, p, 8);
+        p += 8;
+        return true;
+    }
+
+    bool bytes(std::string_view& value) {
+        uint64_t len;
+        if (!varint(len) || len > (uint64_t)(end - p)) {
+            return false;
+        }
+        value = std::string_view((const char*)p, (size_t)len);
+        p += len;
+        return true;
+    }
+
+    bool skip(uint32_t wire) {
+        uint64_t u64;
+        uint32_t u32;
+        std::string_view sv;
+        switch (wire) {
+        case WIRE_VARINT: return varint(u64);
+        case WIRE_FIXED64: return fixed64(u64);
+        case WIRE_LEN: return bytes(sv);
+        case WIRE_FIXED32: return fixed32(u32);
+        default: return false;    // Groups are not used by Sparkplug
+        }
+    }
+
+private:
+    const uint8_t* p;
+    const uint8_t* end;
+};
+
+// Payload.Metric fields kept until the datatype (which may come after the value) is known
+struct RawMetric {
+    uint64_t int_value = 0;
+    uint32_t value_field = 0;     // 10..15 for the scalar oneof members, 0 for none
+    double double_value = 0;
+    std::string_view string_value;
+    bool is_null = false;
+};
+
+DecodedMetric::Value typed_value(const RawMetric& raw, uint32_t datatype) {
+    if (raw.is_null) {
+        return std::monostate();
+    }
+    switch (raw.value_field) {
+    case 10:    // int_value (uint32)
+        switch (datatype) {
+        case SP_INT8: return (int64_t)(int8_t)raw.int_value;
+        case SP_INT16: return (int64_t)(int16_t)raw.int_value;
+        case SP_INT32: return (int64_t)(int32_t)raw.int_value;
+        default: return (uint64_t)(uint32_t)raw.int_value;
+        }
+    case 11:    // long_value (uint64)
+        if (datatype == SP_UINT64 || datatype == SP_UINT32) {
+            return raw.int_value;
+        }
+        return (int64_t)raw.int_value;
+    case 12:    // float_value
+    case 13:    // double_value
+        return raw.double_value;
+    case 14:    // boolean_value
+        return raw.int_value != 0;
+    case 15:    // string_value
+        return raw.string_value;
+    default:
+        return std::monostate();
+    }
+}
+
+bool decode_metric(std::string_view bytes, int64_t default_timestamp, DecodedMetric& metric) {
+    ProtoReader in(bytes);
+    RawMetric raw;
+    uint32_t datatype = SP_UNKNOWN;
+    bool has_timestamp = false;
+
+    while (!in.done()) {
+        uint32_t field, wire;
+        if (!in.tag(field, wire)) {
+            return false;
+        }
+        uint64_t v = 0;
+        bool ok;
+        switch (field) {
+        case 1:     // name
+            ok = wire == WIRE_LEN && in.bytes(metric.name);
+            break;
+        case 2:     // alias
+            ok = wire == WIRE_VARINT && in.varint(metric.alias);
+            metric.has_alias = ok;
+            break;
+        case 3:     // timestamp
+            ok = wire == WIRE_VARINT && in.varint(v);
+            if (ok) {
+                metric.timestamp_ms = (int64_t)v;
+                has_timestamp = true;
+            }
+            break;
+        case 4:     // datatype
+            ok = wire == WIRE_VARINT && in.varint(v);
+            if (ok) {
+                datatype = (uint32_t)v;
+            }
+            break;
+        case 7:     // is_null
+            ok = wire == WIRE_VARINT && in.varint(v);
+            if (ok) {
+                raw.is_null = v != 0;
+            }
+            break;
+        case 10:    // int_value
+        case 11:    // long_value
+        case 14:    // boolean_value
+            ok = wire == WIRE_VARINT && in.varint(raw.int_value);
+            raw.value_field = field;
+            break;
+        case 12: {  // float_value
+            uint32_t bits = 0;
+            float f;
+            ok = wire == WIRE_FIXED32 && in.fixed32(bits);
+            std::memcpy(&f, &bits, 4);
+            raw.double_value = f;
+            raw.value_field = field;
+            break;
+        }
+        case 13: {  // double_value
+            uint64_t bits = 0;
+            ok = wire == WIRE_FIXED64 && in.fixed64(bits);
+            std::memcpy(&raw.double_value, &bits, 8);
+            raw.value_field = field;
+            break;
+        }
+        case 15:    // string_value
+            ok = wire == WIRE_LEN && in.bytes(raw.string_value);
+            raw.value_field = field;
+            break;
+        default:    // is_historical, is_transient, metadata, properties, bytes/dataset/template/extension
+            ok = in.skip(wire);
+            if (field >= 16 && field <= 19) {
+                raw.value_field = 0;
+            }
+            break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+
+    if (!has_timestamp) {
+        metric.timestamp_ms = default_timestamp;
+    }
+    metric.data_type = sparkplug_datatype_name(datatype);
+    metric.value = typed_value(raw, datatype);
+    return true;
+}
+
+void put_varint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out += (char)((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    out += (char)v;
+}
+
+void put_tag(std::string& out, uint32_t field, uint32_t wire) {
+    put_varint(out, ((uint64_t)field << 3) | wire);
+}
+
+void put_bytes(std::string& out, uint32_t field, std::string_view bytes) {
+    put_tag(out, field, WIRE_LEN);
+    put_varint(out, bytes.size());
+    out.append(bytes.data(), bytes.size());
+}
+
+}  // namespace
+
+std::string_view sparkplug_datatype_name(uint32_t datatype) {
+    if (datatype < sizeof(DATATYPE_NAMES) / sizeof(DATATYPE_NAMES[0])) {
+        return DATATYPE_NAMES[datatype];
+    }
+    return std::string_view();
+}
+
+uint32_t sparkplug_datatype_from_name(std::string_view name) {
+    for (uint32_t i = 1; i < sizeof(DATATYPE_NAMES) / sizeof(DATATYPE_NAMES[0]); ++i) {
+        if (DATATYPE_NAMES[i] == name) {
+            return i;
+        }
+    }
+    return SP_UNKNOWN;
+}
+
+bool decode_sparkplug_protobuf(std::string_view bytes, DecodedMessage& msg, std::string& error) {
+    // First pass: validate the top level and count metrics, so the vector is sized once
+    size_t metric_count = 0;
+    {
+        ProtoReader in(bytes);
+        while (!in.done()) {
+            uint32_t field, wire;
+            if (!in.tag(field, wire) || !in.skip(wire)) {
+                error = "malformed protobuf payload";
+                return false;
+            }
+            metric_count += field == 2 && wire == WIRE_LEN;
+        }
+    }
+
+    // Second pass: the framing is known to be valid, only field contents can still fail
+    ProtoReader in(bytes);
+    msg.metrics.clear();
+    msg.metrics.reserve(metric_count);
+
+    while (!in.done()) {
+        uint32_t field, wire;
+        in.tag(field, wire);
+        uint64_t v = 0;
+        std::string_view sv;
+        if (field == 1 && wire == WIRE_VARINT) {
+            in.varint(v);
+            msg.timestamp_ms = (int64_t)v;
+            msg.has_timestamp = true;
+        } else if (field == 3 && wire == WIRE_VARINT) {
+            in.varint(v);
+            msg.seq = (int64_t)v;
+            msg.has_seq = true;
+        } else if (field == 2 && wire == WIRE_LEN) {
+            in.bytes(sv);
+            msg.metrics.emplace_back();
+            // Metrics inherit the payload timestamp, which may come after them: fixed up below
+            if (!decode_metric(sv, INT64_MIN, msg.metrics.back())) {
+                error = "malformed metric " + std::to_string(msg.metrics.size() - 1);
+                msg.metrics.clear();
+                return false;
+            }
+        } else {
+            in.skip(wire);    // uuid, body
+        }
+    }
+
+    for (DecodedMetric& metric : msg.metrics) {
+        if (metric.timestamp_ms == INT64_MIN) {
+            metric.timestamp_ms = msg.timestamp_ms;
+        }
+    }
+    return true;
+}
+
+std::string encode_sparkplug_protobuf(int64_t timestamp_ms, int64_t seq, const std::vector<DecodedMetric>& metrics) {
+    std::string out;
+    std::string m;
+    put_tag(out, 1, WIRE_VARINT);
+    put_varint(out, (uint64_t)timestamp_ms);
+
+    for (const DecodedMetric& metric : metrics) {
+        m.clear();
+        if (!metric.name.empty()) {
+            put_bytes(m, 1, metric.name);
+        }
+        if (metric.has_alias) {
+            put_tag(m, 2, WIRE_VARINT);
+            put_varint(m, metric.alias);
+        }
+        put_tag(m, 3, WIRE_VARINT);
+        put_varint(m, (uint64_t)metric.timestamp_ms);
+
+        uint32_t datatype = sparkplug_datatype_from_name(metric.data_type);
+        if (auto v = std::get_if<bool>(&metric.value)) {
+            datatype = SP_BOOLEAN;
+            put_tag(m, 14, WIRE_VARINT);
+            put_varint(m, *v ? 1 : 0);
+        } else if (auto v = std::get_if<double>(&metric.value)) {
+            if (datatype != SP_FLOAT) {
+                datatype = SP_DOUBLE;
+            }
+            if (datatype == SP_FLOAT) {
+                float f = (float)*v;
+                uint32_t bits;
+                std::memcpy(&bits, &f, 4);
+                put_tag(m, 12, WIRE_FIXED32);
+                m.append((const char*)&bits, 4);
+            } else {
+                uint64_t bits;
+                std::memcpy(&bits, v, 8);
+                put_tag(m, 13, WIRE_FIXED64);
+                m.append((const char*)&bits, 8);
+            }
+        } else if (auto v = std::get_if<int64_t>(&metric.value)) {
+            datatype = SP_INT64;
+            put_tag(m, 11, WIRE_VARINT);
+            put_varint(m, (uint64_t)*v);
+        } else if (auto v = std::get_if<uint64_t>(&metric.value)) {
+            datatype = SP_UINT64;
+            put_tag(m, 11, WIRE_VARINT);
+            put_varint(m, *v);
+        } else if (auto v = std::get_if<std::string_view>(&metric.value)) {
+            datatype = SP_STRING;
+            put_bytes(m, 15, *v);
+        } else {
+            put_tag(m, 7, WIRE_VARINT);
+            put_varint(m, 1);
+        }
+        put_tag(m, 4, WIRE_VARINT);
+        put_varint(m, datatype);
+
+        put_bytes(out, 2, m);
+    }
+
+    put_tag(out, 3, WIRE_VARINT);
+    put_varint(out, (uint64_t)seq);
+    return out;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "decodedMessage.h"
+
+/**
+ * Hand written decoder for the Sparkplug B protobuf payload
+ * (org.eclipse.tahu.protobuf.Payload / Payload.Metric). Only what the subscriber uses is
+ * decoded: timestamp, seq and per metric name, alias, timestamp, datatype and scalar value.
+ * Metadata, properties, datasets and templates are skipped.
+ *
+ * Names and string values are string_views into the payload bytes, so decoding allocates
+ * nothing per metric (the metrics vector is sized once up front).
+ */
+
+// Sparkplug B DataType enum values used by the decoder
+enum SparkplugDataType : uint32_t {
+    SP_UNKNOWN = 0,
+    SP_INT8 = 1,
+    SP_INT16 = 2,
+    SP_INT32 = 3,
+    SP_INT64 = 4,
+    SP_UINT8 = 5,
+    SP_UINT16 = 6,
+    SP_UINT32 = 7,
+    SP_UINT64 = 8,
+    SP_FLOAT = 9,
+    SP_DOUBLE = 10,
+    SP_BOOLEAN = 11,
+    SP_STRING = 12,
+    SP_DATETIME = 13,
+    SP_TEXT = 14,
+    SP_UUID = 15,
+    SP_DATASET = 16,
+    SP_BYTES = 17,
+    SP_FILE = 18,
+    SP_TEMPLATE = 19
+};
+
+// "Float", "UInt64", ... as used in the JSON form; "" for unknown values
+std::string_view sparkplug_datatype_name(uint32_t datatype);
+uint32_t sparkplug_datatype_from_name(std::string_view name);
+
+/**
+ * Decode a protobuf payload into msg.timestamp_ms / seq / metrics.
+ * Returns false with `error` set when the bytes are not a valid Payload message.
+ */
+bool decode_sparkplug_protobuf(std::string_view bytes, DecodedMessage& msg, std::string& error);
+
+/**
+ * Encode timestamp/seq/metrics as a Sparkplug B protobuf Payload.
+ * Used by the benchmarks and tools; the datatype comes from DecodedMetric::data_type.
+ */
+std::string encode_sparkplug_protobuf(int64_t timestamp_ms, int64_t seq, const std::vector<DecodedMetric>& metrics);
@@ -0,0 +1,149 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Sparkplug B message types, in topic position 3 (spBv1.0/{group}/{type}/...)
+ */
+enum class MessageType {
+    NBIRTH,
+    NDEATH,
+    DBIRTH,
+    DDEATH,
+    NDATA,
+    DDATA,
+    NCMD,
+    DCMD,
+    STATE,
+    Unknown
+};
+
+inline const char* message_type_name(MessageType type) {
+    switch (type) {
+    case MessageType::NBIRTH: return "NBIRTH";
+    case MessageType::NDEATH: return "NDEATH";
+    case MessageType::DBIRTH: return "DBIRTH";
+    case MessageType::DDEATH: return "DDEATH";
+    case MessageType::NDATA: return "NDATA";
+    case MessageType::DDATA: return "DDATA";
+    case MessageType::NCMD: return "NCMD";
+    case MessageType::DCMD: return "DCMD";
+    case MessageType::STATE: return "STATE";
+    default: return "UNKNOWN";
+    }
+}
+
+// Dispatch on length and first letter, so at most one full compare per call
+inline MessageType message_type_from(std::string_view s) {
+    switch (s.size()) {
+    case 4:
+        if (s == "NCMD") return MessageType::NCMD;
+        if (s == "DCMD") return MessageType::DCMD;
+        break;
+    case 5:
+        if (s[0] == 'D') return s == "DDATA" ? MessageType::DDATA : MessageType::Unknown;
+        if (s[0] == 'N') return s == "NDATA" ? MessageType::NDATA : MessageType::Unknown;
+        if (s == "STATE") return MessageType::STATE;
+        break;
+    case 6:
+        if (s[0] == 'N') {
+            if (s == "NBIRTH") return MessageType::NBIRTH;
+            if (s == "NDEATH") return MessageType::NDEATH;
+        } else if (s[0] == 'D') {
+            if (s == "DBIRTH") return MessageType::DBIRTH;
+            if (s == "DDEATH") return MessageType::DDEATH;
+        }
+        break;
+    }
+    return MessageType::Unknown;
+}
+
+/**
+ * Fields of a Sparkplug B topic: spBv1.0/{group_id}/{message_type}/{node_id}[/{device_id}]
+ * All views point into the topic string passed to parse_sparkplug_topic(),
+ * which must outlive this struct.
+ */
+struct SparkplugTopic {
+    std::string_view topic;        // The whole topic
+    std::string_view group_id;
+    std::string_view node_id;
+    std::string_view device_id;    // Empty for node level messages
+    MessageType type = MessageType::Unknown;
+
+    bool valid() const { return type != MessageType::Unknown; }
+    bool is_device() const { return !device_id.empty(); }
+};
+
+/**
+ * Single pass, allocation free parse of a Sparkplug B topic.
+ * Topics with too few/many levels or an unknown message type come back with type Unknown
+ * (group/node are still filled in where present, for logging).
+ */
+inline SparkplugTopic parse_sparkplug_topic(std::string_view topic) {
+    SparkplugTopic t;
+    t.topic = topic;
+
+    std::string_view parts[5];
+    size_t count = 0;
+    size_t start = 0;
+    for (;;) {
+        size_t slash = topic.find('/', start);
+        if (count == 5) {
+            return t;   // More than 5 levels is not Sparkplug
+        }
+        if (slash == std::string_view::npos) {
+            parts[count++] = topic.substr(start);
+            break;
+        }
+        parts[count++] = topic.substr(start, slash - start);
+        start = slash + 1;
+    }
+
+    if (count < 3) {
+        return t;
+    }
+    t.group_id = parts[1];
+    if (count == 3) {
+        // spBv1.0/STATE/{host_id}
+        if (parts[1] == "STATE") {
+            t.group_id = std::string_view();
+            t.node_id = parts[2];
+            t.type = MessageType::STATE;
+        }
+        return t;
+    }
+
+    t.node_id = parts[3];
+    if (count == 5) {
+        t.device_id = parts[4];
+    }
+    if (t.group_id.empty() || t.node_id.empty()) {
+        return t;
+    }
+
+    MessageType type = message_type_from(parts[2]);
+    bool device_type = type == MessageType::DBIRTH || type == MessageType::DDEATH ||
+                       type == MessageType::DDATA || type == MessageType::DCMD;
+    if (type != MessageType::STATE && device_type == (count == 5) && (count == 4 || !t.device_id.empty())) {
+        t.type = type;
+    }
+    return t;
+}
+
+/**
+ * FNV-1a of group_id/node_id. Unlike std::hash it is the same in every process and build,
+ * so separate subscriber instances agree on which of them owns a node.
+ */
+inline uint64_t stable_node_hash(const SparkplugTopic& topic) {
+    uint64_t h = 1469598103934665603ULL;
+    auto mix = [&h](std::string_view s) {
+        for (unsigned char c : s) {
+            h = (h ^ c) * 1099511628211ULL;
+        }
+    };
+    mix(topic.group_id);
+    mix("/");
+    mix(topic.node_id);
+    return h;
+}
@@ -8,9 +8,12 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <atomic>
+#include <mutex>
 #include <memory>
 #include <chrono>
 #include <string>
+#include "decodedMessage.h"
+#include "logging.h"
 
 using json = nlohmann::json;
 
@@ -21,6 +24,8 @@ private:
     std::shared_ptr<spdlog::logger> access_logger;
     std::shared_ptr<spdlog::logger> system_logger;
     
+    // Node state is shared by the ingest workers and the periodic check thread
+    std::mutex state_mutex;
     std::unordered_map<std::string, std::vector<std::chrono::steady_clock::time_point>> client_failures;
     std::unordered_set<std::string> registered_nodes;
     std::unordered_map<std::string, std::chrono::steady_clock::time_point> last_birth_messages;
@@ -30,22 +35,19 @@ private:
 public:
         
     void setup_loggers();
+    // Every logger writes to the one sink given, unregistered; e.g. a null sink in benchmarks
+    void setup_loggers(const spdlog::sink_ptr& sink);
     void log_subscriber_start();
     void log_broker_connection(const std::string& server, const std::string& client_id);
     void log_topic_subscription(const std::string& topic);
-    void analyze_nbirth_message(const std::string& topic, const std::string& payload);
-    void analyze_ndata_message(const std::string& topic, const std::string& payload);
-    void analyze_ddata_message(const std::string& topic, const std::string& payload);
-    void analyze_ndeath_message(const std::string& topic, const std::string& payload);    
-    void analyze_ncmd_message(const std::string& topic, const std::string& payload);
-    void analyze_dcmd_message(const std::string& topic, const std::string& payload);    
+    void analyze_nbirth_message(const DecodedMessage& msg);
+    void analyze_ndata_message(const DecodedMessage& msg);
+    void analyze_ddata_message(const DecodedMessage& msg);
+    void analyze_ndeath_message(const DecodedMessage& msg);    
+    void analyze_ncmd_message(const DecodedMessage& msg);
+    void analyze_dcmd_message(const DecodedMessage& msg);    
     void log_connection_failure(const std::string& error_msg);
     void log_subscription_failure(const std::string& topic, const std::string& error_msg);
     void log_disconnect();
     void perform_periodic_checks();
-
-private:
-    std::string extract_node_from_topic(const std::string& topic);
-    std::string extract_device_from_topic(const std::string& topic);
-    std::string get_metric_value_as_string(const json& value);
 };
\ No newline at end of file
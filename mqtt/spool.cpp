@@ -0,0 +1,440 @@
+#include "spool.h"
+#include "subscriberConfig.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t RECORD_MAGIC = 0x4c4f5053;   // "SPOL"
+constexpr size_t HEADER_BYTES = 12;             // magic, length, crc32
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t length;
+    uint32_t crc;
+};
+
+// CRC-32 (IEEE 802.3), table driven
+uint32_t crc32(const char* data, size_t len) {
+    static const std::vector<uint32_t> table = [] {
+        std::vector<uint32_t> t(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; ++i) {
+        crc = table[(crc ^ (uint8_t)data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// Record at `offset`, false when it is missing, torn or fails the CRC
+bool read_record(const char* data, size_t used, size_t offset, std::string_view& record) {
+    if (offset + HEADER_BYTES > used) {
+        return false;
+    }
+    RecordHeader h;
+    std::memcpy(&h, data + offset, HEADER_BYTES);
+    if (h.magic != RECORD_MAGIC || h.length > used - offset - HEADER_BYTES) {
+        return false;
+    }
+    const char* bytes = data + offset + HEADER_BYTES;
+    if (crc32(bytes, h.length) != h.crc) {
+        return false;
+    }
+    record = std::string_view(bytes, h.length);
+    return true;
+}
+
+// Length of the valid prefix of a segment (stops at the first torn or corrupt record)
+size_t scan_records(const char* data, size_t size, uint64_t& records) {
+    size_t offset = 0;
+    std::string_view record;
+    records = 0;
+    while (read_record(data, size, offset, record)) {
+        offset += HEADER_BYTES + record.size();
+        records++;
+    }
+    return offset;
+}
+
+bool make_dirs(const std::string& path) {
+    for (size_t pos = 1; pos <= path.size(); ++pos) {
+        if (pos == path.size() || path[pos] == '/') {
+            std::string part = path.substr(0, pos);
+            if (mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+SpoolOptions SpoolOptions::from_env() {
+    SpoolOptions o;
+    o.dir = env_string("SPOOL_DIR", o.dir);
+    o.max_bytes = (uint64_t)std::max(1L << 20, env_long("SPOOL_MAX_BYTES", (long)o.max_bytes));
+    o.segment_bytes = (size_t)std::max(64L * 1024, env_long("SPOOL_SEGMENT_BYTES", (long)o.segment_bytes));
+    // At least two segments under the cap, so eviction always has a sealed segment to drop
+    o.segment_bytes = (size_t)std::min<uint64_t>(o.segment_bytes, o.max_bytes / 2);
+    o.fsync_bytes = (size_t)std::max(0L, env_long("SPOOL_FSYNC_BYTES", (long)o.fsync_bytes));
+    o.fsync_interval = std::chrono::milliseconds(
+        std::max(1L, env_long("SPOOL_FSYNC_INTERVAL_MS", (long)o.fsync_interval.count())));
+    o.replay_max_per_sec = std::max(0L, env_long("SPOOL_REPLAY_MAX_PER_SEC", o.replay_max_per_sec));
+    o.replay_max_attempts = (int)std::max(0L, env_long("SPOOL_REPLAY_MAX_ATTEMPTS", o.replay_max_attempts));
+    return o;
+}
+
+Spool::Spool(const SpoolOptions& options, const std::string& name)
+    : options(options), dir(options.dir + "/" + name) {
+    last_sync = std::chrono::steady_clock::now();
+    if (!make_dirs(dir)) {
+        spdlog::error("Spool {}: cannot create directory: {}", dir, std::strerror(errno));
+        return;
+    }
+    recover();
+    ok = open_active(options.segment_bytes);
+    if (ok) {
+        spdlog::info("Spool {} ready - {} records pending ({} bytes)", dir, pending_records, total_bytes);
+    }
+}
+
+Spool::~Spool() {
+    if (!ok) {
+        return;
+    }
+    sync();
+    for (Segment& seg : segments) {
+        if (seg.writable) {
+            seal(seg);
+        }
+        close_segment(seg);
+        if (seg.used == 0) {
+            unlink(segment_path(seg.seq).c_str());
+        }
+    }
+}
+
+std::string Spool::segment_path(uint64_t seq) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%020llu.seg", (unsigned long long)seq);
+    return dir + "/" + name;
+}
+
+bool Spool::map_segment(Segment& seg, bool writable) {
+    if (seg.fd < 0) {
+        seg.fd = open(segment_path(seg.seq).c_str(), writable ? O_RDWR : O_RDONLY);
+        if (seg.fd < 0) {
+            spdlog::error("Spool {}: cannot open segment {}: {}", dir, seg.seq, std::strerror(errno));
+            return false;
+        }
+    }
+    struct stat st;
+    if (fstat(seg.fd, &st) != 0 || st.st_size == 0) {
+        return false;
+    }
+    seg.capacity = (size_t)st.st_size;
+    void* map = mmap(nullptr, seg.capacity, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, seg.fd, 0);
+    if (map == MAP_FAILED) {
+        spdlog::error("Spool {}: mmap of segment {} failed: {}", dir, seg.seq, std::strerror(errno));
+        return false;
+    }
+    seg.map = (char*)map;
+    seg.writable = writable;
+    if (!writable) {
+        madvise(seg.map, seg.capacity, MADV_SEQUENTIAL);
+    }
+    return true;
+}
+
+void Spool::close_segment(Segment& seg) {
+    if (seg.map) {
+        munmap(seg.map, seg.capacity);
+        seg.map = nullptr;
+    }
+    if (seg.fd >= 0) {
+        close(seg.fd);
+        seg.fd = -1;
+    }
+    seg.writable = false;
+}
+
+bool Spool::open_active(size_t min_capacity) {
+    Segment seg;
+    seg.seq = next_seq++;
+    std::string path = segment_path(seg.seq);
+
+    seg.fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (seg.fd < 0) {
+        spdlog::error("Spool {}: cannot create segment: {}", dir, std::strerror(errno));
+        return false;
+    }
+    // Reserve the blocks now: writing into a sparse mapping on a full disk raises SIGBUS
+    size_t capacity = std::max(options.segment_bytes, min_capacity);
+    int err = posix_fallocate(seg.fd, 0, (off_t)capacity);
+    if (err != 0) {
+        spdlog::error("Spool {}: cannot reserve {} bytes: {}", dir, capacity, std::strerror(err));
+        close(seg.fd);
+        unlink(path.c_str());
+        return false;
+    }
+    if (!map_segment(seg, true)) {
+        close_segment(seg);
+        unlink(path.c_str());
+        return false;
+    }
+    segments.push_back(seg);
+    synced_offset = 0;
+    return true;
+}
+
+void Spool::seal(Segment& seg) {
+    if (seg.map) {
+        msync(seg.map, seg.used, MS_SYNC);
+        munmap(seg.map, seg.capacity);
+        seg.map = nullptr;
+    }
+    if (seg.fd >= 0) {
+        // Give back the preallocated tail
+        if (ftruncate(seg.fd, (off_t)seg.used) != 0) {
+            spdlog::warn("Spool {}: truncate of segment {} failed: {}", dir, seg.seq, std::strerror(errno));
+        }
+        fsync(seg.fd);
+        close(seg.fd);
+        seg.fd = -1;
+    }
+    seg.capacity = 0;
+    seg.writable = false;
+}
+
+void Spool::drop_front(bool evicted) {
+    Segment& front = segments.front();
+    uint64_t unread = front.records - read_records;
+    if (evicted && unread > 0) {
+        counters.evicted_records += unread;
+        spdlog::warn("Spool {}: size cap reached, dropped segment {} with {} unsent records", dir, front.seq, unread);
+    }
+    pending_records -= unread;
+    total_bytes -= front.used;
+    close_segment(front);
+    unlink(segment_path(front.seq).c_str());
+    segments.pop_front();
+
+    read_offset = 0;
+    read_records = 0;
+    peeked_length = 0;
+    cursor_dirty = true;
+}
+
+bool Spool::append(std::string_view record) {
+    size_t need = HEADER_BYTES + record.size();
+    if (!ok || record.size() > UINT32_MAX || need > options.max_bytes) {
+        counters.rejected++;
+        return false;
+    }
+
+    // Size cap: make room by dropping the oldest sealed segments
+    while (total_bytes + need > options.max_bytes && segments.size() > 1) {
+        drop_front(true);
+    }
+
+    Segment* active = &segments.back();
+    if (active->used + need > active->capacity) {
+        seal(*active);
+        if (!open_active(need)) {
+            counters.rejected++;
+            return false;
+        }
+        active = &segments.back();
+    }
+
+    char* at = active->map + active->used;
+    RecordHeader h{RECORD_MAGIC, (uint32_t)record.size(), crc32(record.data(), record.size())};
+    std::memcpy(at + HEADER_BYTES, record.data(), record.size());
+    std::memcpy(at, &h, HEADER_BYTES);
+
+    active->used += need;
+    active->records++;
+    pending_records++;
+    total_bytes += need;
+    unsynced_bytes += need;
+    counters.appended++;
+    peeked_length = 0;
+
+    maybe_sync();
+    return true;
+}
+
+bool Spool::peek(std::string_view& record) {
+    while (pending_records > 0 && !segments.empty()) {
+        Segment& front = segments.front();
+        if (read_offset >= front.used) {
+            if (segments.size() == 1) {
+                return false;
+            }
+            drop_front(false);
+            continue;
+        }
+        if (!front.map && !map_segment(front, false)) {
+            drop_front(true);
+            continue;
+        }
+        if (!read_record(front.map, front.used, read_offset, record)) {
+            // Only possible if the file was changed behind our back: skip the rest of the segment
+            uint64_t lost = front.records - read_records;
+            spdlog::error("Spool {}: corrupt record in segment {} at {}, skipping {} records",
+                          dir, front.seq, read_offset, lost);
+            counters.evicted_records += lost;
+            pending_records -= lost;
+            read_offset = front.used;
+            read_records = front.records;
+            continue;
+        }
+        peeked_length = HEADER_BYTES + record.size();
+        return true;
+    }
+    return false;
+}
+
+void Spool::ack() {
+    if (peeked_length == 0) {
+        return;
+    }
+    read_offset += peeked_length;
+    read_records++;
+    pending_records--;
+    counters.acked++;
+    peeked_length = 0;
+    cursor_dirty = true;
+
+    if (read_offset >= segments.front().used && segments.size() > 1) {
+        drop_front(false);
+    }
+}
+
+void Spool::sync() {
+    if (!segments.empty()) {
+        Segment& active = segments.back();
+        if (active.writable && active.used > synced_offset) {
+            size_t page = (size_t)sysconf(_SC_PAGESIZE);
+            size_t start = synced_offset / page * page;
+            msync(active.map + start, active.used - start, MS_SYNC);
+            synced_offset = active.used;
+        }
+    }
+    if (cursor_dirty) {
+        save_cursor();
+    }
+    unsynced_bytes = 0;
+    last_sync = std::chrono::steady_clock::now();
+}
+
+void Spool::maybe_sync() {
+    if (unsynced_bytes == 0 && !cursor_dirty) {
+        return;
+    }
+    if (unsynced_bytes >= options.fsync_bytes ||
+        std::chrono::steady_clock::now() - last_sync >= options.fsync_interval) {
+        sync();
+    }
+}
+
+void Spool::save_cursor() {
+    if (segments.empty()) {
+        return;
+    }
+    std::string tmp = dir + "/cursor.tmp";
+    FILE* f = std::fopen(tmp.c_str(), "w");
+    if (!f) {
+        return;
+    }
+    std::fprintf(f, "%llu %zu %llu\n", (unsigned long long)segments.front().seq, read_offset,
+                 (unsigned long long)read_records);
+    std::fflush(f);
+    fsync(fileno(f));
+    std::fclose(f);
+    std::rename(tmp.c_str(), (dir + "/cursor").c_str());
+    cursor_dirty = false;
+}
+
+void Spool::recover() {
+    std::vector<uint64_t> seqs;
+    if (DIR* d = opendir(dir.c_str())) {
+        while (dirent* e = readdir(d)) {
+            std::string name = e->d_name;
+            if (name.size() == 24 && name.compare(20, 4, ".seg") == 0) {
+                seqs.push_back(std::strtoull(name.c_str(), nullptr, 10));
+            }
+        }
+        closedir(d);
+    }
+    std::sort(seqs.begin(), seqs.end());
+    if (!seqs.empty()) {
+        next_seq = seqs.back() + 1;
+    }
+
+    unsigned long long cursor_seq = 0, cursor_records = 0;
+    size_t cursor_offset = 0;
+    if (FILE* f = std::fopen((dir + "/cursor").c_str(), "r")) {
+        if (std::fscanf(f, "%llu %zu %llu", &cursor_seq, &cursor_offset, &cursor_records) != 3) {
+            cursor_seq = 0;
+        }
+        std::fclose(f);
+    }
+    next_seq = std::max<uint64_t>(next_seq, cursor_seq + 1);
+
+    for (uint64_t seq : seqs) {
+        Segment seg;
+        seg.seq = seq;
+        std::string path = segment_path(seq);
+        if (seq < cursor_seq) {
+            unlink(path.c_str());     // Fully delivered before the restart
+            continue;
+        }
+        seg.fd = open(path.c_str(), O_RDWR);
+        if (seg.fd < 0) {
+            continue;
+        }
+        if (map_segment(seg, false)) {
+            seg.used = scan_records(seg.map, seg.capacity, seg.records);
+        }
+        // Cut the torn tail (or unused preallocation) of the segment that was active at the crash
+        if (seg.capacity != seg.used && ftruncate(seg.fd, (off_t)seg.used) != 0) {
+            spdlog::warn("Spool {}: truncate of segment {} failed", dir, seq);
+        }
+        close_segment(seg);
+        if (seg.used == 0) {
+            unlink(path.c_str());
+            continue;
+        }
+        seg.capacity = 0;
+        segments.push_back(seg);
+        total_bytes += seg.used;
+        pending_records += seg.records;
+    }
+
+    if (!segments.empty() && segments.front().seq == cursor_seq && cursor_offset <= segments.front().used &&
+        cursor_records <= segments.front().records) {
+        read_offset = cursor_offset;
+        read_records = cursor_records;
+        pending_records -= cursor_records;
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+
+/**
+ * Spool settings, shared by every sink (each sink gets its own sub directory)
+ */
+struct SpoolOptions {
+    std::string dir;                                    // SPOOL_DIR, empty disables spooling
+    size_t segment_bytes = 64 * 1024 * 1024;            // SPOOL_SEGMENT_BYTES
+    uint64_t max_bytes = 4ULL * 1024 * 1024 * 1024;     // SPOOL_MAX_BYTES, oldest segments are evicted beyond this
+    size_t fsync_bytes = 1024 * 1024;                   // SPOOL_FSYNC_BYTES
+    std::chrono::milliseconds fsync_interval{200};      // SPOOL_FSYNC_INTERVAL_MS
+    long replay_max_per_sec = 20000;                    // SPOOL_REPLAY_MAX_PER_SEC (messages), 0 = unlimited
+    int replay_max_attempts = 50;                       // SPOOL_REPLAY_MAX_ATTEMPTS per record, then dead-lettered, 0 = never
+
+    static SpoolOptions from_env();
+};
+
+/**
+ * Append-only, segment based store-and-forward queue on disk.
+ *
+ * Records are appended to an mmap'ed segment file (preallocated, so a full disk fails the
+ * append instead of faulting) as [magic][length][crc32][bytes]. Syncs are grouped: msync
+ * runs once fsync_bytes have been written or fsync_interval has passed, whichever is first.
+ * Records are read back in order with peek()/ack(); fully read segments are deleted.
+ * The read position is saved with every sync, so after a crash records are replayed at
+ * least once. A torn or corrupt tail is detected by the CRC and cut off on startup.
+ *
+ * Not thread safe: owned and used by one SinkRunner thread.
+ */
+class Spool {
+public:
+    struct Stats {
+        uint64_t appended = 0;
+        uint64_t acked = 0;
+        uint64_t evicted_records = 0;   // Lost to the size cap
+        uint64_t rejected = 0;          // Appends that failed (disk full, record larger than the cap)
+    };
+
+    Spool(const SpoolOptions& options, const std::string& name);
+    ~Spool();
+
+    Spool(const Spool&) = delete;
+    Spool& operator=(const Spool&) = delete;
+
+    bool usable() const { return ok; }
+
+    bool append(std::string_view record);
+
+    // Oldest unacknowledged record; the view stays valid until ack() or the next append()
+    bool peek(std::string_view& record);
+    void ack();
+
+    void sync();
+    void maybe_sync();
+    // Every appended record has been synced to disk
+    bool synced() const { return unsynced_bytes == 0; }
+
+    bool empty() const { return pending_records == 0; }
+    uint64_t pending() const { return pending_records; }
+    uint64_t bytes_on_disk() const { return total_bytes; }
+    const Stats& stats() const { return counters; }
+    const std::string& directory() const { return dir; }
+    const SpoolOptions& config() const { return options; }
+
+private:
+    struct Segment {
+        uint64_t seq = 0;
+        int fd = -1;
+        char* map = nullptr;
+        size_t capacity = 0;    // Mapped length
+        size_t used = 0;        // Bytes holding valid records
+        uint64_t records = 0;
+        bool writable = false;
+    };
+
+    std::string segment_path(uint64_t seq) const;
+    bool open_active(size_t min_capacity);
+    bool map_segment(Segment& seg, bool writable);
+    void seal(Segment& seg);
+    void close_segment(Segment& seg);
+    void drop_front(bool evicted);
+    void recover();
+    void save_cursor();
+
+    SpoolOptions options;
+    std::string dir;
+    bool ok = false;
+
+    std::deque<Segment> segments;   // Oldest first, back() is the one being written
+    uint64_t next_seq = 1;
+    size_t read_offset = 0;         // In segments.front()
+    uint64_t read_records = 0;      // Records of segments.front() already acked
+    size_t peeked_length = 0;       // Size of the record handed out by peek()
+    uint64_t pending_records = 0;
+    uint64_t total_bytes = 0;
+
+    size_t unsynced_bytes = 0;
+    size_t synced_offset = 0;       // Of the active segment
+    bool cursor_dirty = false;
+    std::chrono::steady_clock::time_point last_sync;
+
+    Stats counters;
+};
@@ -0,0 +1,86 @@
+#include "subscriberConfig.h"
+#include <algorithm>
+#include <cstdlib>
+#include <unistd.h>
+
+std::string env_string(const char* name, const std::string& fallback) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) {
+        return fallback;
+    }
+    return value;
+}
+
+long env_long(const char* name, long fallback) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) {
+        return fallback;
+    }
+    char* end = nullptr;
+    long parsed = std::strtol(value, &end, 10);
+    return (end && *end == '\0') ? parsed : fallback;
+}
+
+SubscriberConfig SubscriberConfig::from_env() {
+    SubscriberConfig cfg;
+    std::string broker_host = env_string("MQTT_BROKER_HOST", "");
+    if (!broker_host.empty()) {
+        cfg.mqtt_server = "tcp://" + broker_host + ":1883";
+    }
+    cfg.mqtt_server = env_string("MQTT_SERVER", cfg.mqtt_server);
+    cfg.mqtt_version = env_long("MQTT_VERSION", cfg.mqtt_version) == 5 ? 5 : 3;
+    cfg.mqtt_qos = env_long("MQTT_QOS", cfg.mqtt_qos) >= 1 ? 1 : 0;
+    cfg.mqtt_max_inflight = static_cast<size_t>(std::max(0L, env_long("MQTT_MAX_INFLIGHT", (long)cfg.mqtt_max_inflight)));
+    cfg.mqtt_inflight_wait_ms = std::max(1L, env_long("MQTT_INFLIGHT_WAIT_MS", cfg.mqtt_inflight_wait_ms));
+    cfg.mqtt_session_expiry_s = (int)std::max(0L, env_long("MQTT_SESSION_EXPIRY_S", cfg.mqtt_session_expiry_s));
+    cfg.mqtt_share_group = env_string("MQTT_SHARE_GROUP", cfg.mqtt_share_group);
+    cfg.instance_count = static_cast<size_t>(std::max(1L, env_long("MQTT_INSTANCE_COUNT", (long)cfg.instance_count)));
+    cfg.instance_index = static_cast<size_t>(std::max(0L, env_long("MQTT_INSTANCE_INDEX", (long)cfg.instance_index)))
+                         % cfg.instance_count;
+    cfg.instance_index_set = !env_string("MQTT_INSTANCE_INDEX", "").empty();
+    cfg.mqtt_client_id = env_string("MQTT_CLIENT_ID", "");
+    cfg.client_id_set = !cfg.mqtt_client_id.empty();
+    if (!cfg.client_id_set) {
+        // Two clients with the same id kick each other off the broker
+        cfg.mqtt_client_id = "Subscriber";
+        if (!cfg.mqtt_share_group.empty()) {
+            char host[256] = {0};
+            gethostname(host, sizeof(host) - 1);
+            // A persistent session is found again by its client id, so it must survive a restart;
+            // startup_error() makes sure the index was set, or every replica would be "-0"
+            std::string suffix = cfg.mqtt_qos == 1 ? std::to_string(cfg.instance_index) : std::to_string(getpid());
+            cfg.mqtt_client_id += "-" + std::string(host) + "-" + suffix;
+        }
+    }
+    cfg.mqtt_connections = static_cast<size_t>(std::max(1L, env_long("MQTT_CONNECTIONS", (long)cfg.mqtt_connections)));
+    cfg.cpu_affinity = env_string("CPU_AFFINITY", cfg.cpu_affinity);
+    cfg.metrics_port = env_long("METRICS_PORT", cfg.metrics_port);
+    cfg.metrics_bind = env_string("METRICS_BIND", cfg.metrics_bind);
+    cfg.subscriptions_file = env_string("SUBSCRIPTIONS_FILE", cfg.subscriptions_file);
+    cfg.deadband_file = env_string("DEADBAND_FILE", cfg.deadband_file);
+    cfg.fastapi_url = env_string("FASTAPI_URL", cfg.fastapi_url);
+    cfg.http_pool_size = static_cast<size_t>(std::max(1L, env_long("FASTAPI_POOL_SIZE", (long)cfg.http_pool_size)));
+    cfg.http_timeout_ms = env_long("FASTAPI_TIMEOUT_MS", cfg.http_timeout_ms);
+    cfg.ingest_workers = static_cast<size_t>(std::max(1L, env_long("INGEST_WORKERS", (long)cfg.ingest_workers)));
+    cfg.ingest_queue_capacity = static_cast<size_t>(std::max(2L, env_long("INGEST_QUEUE_CAPACITY", (long)cfg.ingest_queue_capacity)));
+    cfg.ingest_overflow = env_string("INGEST_OVERFLOW", cfg.ingest_overflow);
+    cfg.sinks = env_string("SINKS", cfg.sinks);
+    cfg.file_sink_path = env_string("FILE_SINK_PATH", cfg.file_sink_path);
+    cfg.questdb_ilp_tcp_conf = env_string("QUESTDB_ILP_TCP_CONF", cfg.questdb_ilp_tcp_conf);
+    cfg.questdb_ilp_http_conf = env_string("QUESTDB_ILP_HTTP_CONF", cfg.questdb_ilp_http_conf);
+    return cfg;
+}
+
+std::string SubscriberConfig::startup_error() const {
+    if (mqtt_qos == 1 && !mqtt_share_group.empty() && !client_id_set && !instance_index_set) {
+        // Replicas on the same host would share the id Subscriber-<host>-0 and keep taking over
+        // each other's session
+        return "MQTT_QOS=1 with MQTT_SHARE_GROUP needs MQTT_INSTANCE_INDEX (or MQTT_CLIENT_ID) set "
+               "per instance, so each keeps its own persistent session";
+    }
+    return "";
+}
+
+bool SubscriberConfig::owns_node(const SparkplugTopic& topic) const {
+    return instance_count <= 1 || stable_node_hash(topic) % instance_count == instance_index;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include "sparkplugTopic.h"
+
+/**
+ * Runtime settings for paho-sub.
+ * Every field can be overridden through an environment variable (see docker-compose.yml),
+ * the defaults match the docker setup.
+ */
+struct SubscriberConfig {
+    std::string mqtt_server = "tcp://mqtt-broker:1883";    // MQTT_SERVER (or tcp://MQTT_BROKER_HOST:1883)
+    std::string mqtt_client_id = "Subscriber";             // MQTT_CLIENT_ID, made unique per instance when sharing
+    int mqtt_version = 3;                                  // MQTT_VERSION: 3 (v3.1.1) or 5 (subscription ids, latency tracing)
+
+    // QoS 1 on a persistent session: the broker keeps undelivered messages across restarts. This
+    // is not end-to-end at-least-once: Paho acks every message on receipt, so with any
+    // max_inflight (the default 1000 included) what is still between arrival and the sinks is
+    // lost if the process dies. max_inflight only bounds that amount, as backpressure on the
+    // receive path; 0 keeps it to about one message at a time.
+    int mqtt_qos = 0;                                      // MQTT_QOS: 0 or 1
+    size_t mqtt_max_inflight = 1000;                       // MQTT_MAX_INFLIGHT
+    long mqtt_inflight_wait_ms = 1000;                     // MQTT_INFLIGHT_WAIT_MS, longest the callback waits for the window
+    int mqtt_session_expiry_s = 3600;                      // MQTT_SESSION_EXPIRY_S (v5, QoS 1)
+
+    // Scale-out: with a share group the data topics are subscribed as $share/<group>/..., so the
+    // broker splits them over every instance in the group. NBIRTH/NDEATH stay plain subscriptions
+    // so each instance keeps the full node state; only the instance owning a node
+    // (hash(group/node) % count == index) forwards them to the sinks.
+    std::string mqtt_share_group;                          // MQTT_SHARE_GROUP, empty = no sharing
+    size_t instance_index = 0;                             // MQTT_INSTANCE_INDEX
+    size_t instance_count = 1;                             // MQTT_INSTANCE_COUNT
+    bool instance_index_set = false;                       // MQTT_INSTANCE_INDEX given explicitly
+    bool client_id_set = false;                            // MQTT_CLIENT_ID given explicitly
+
+    // Parallel consumers in one process: N connections, each with its own ingest workers and
+    // sinks. With CPU_AFFINITY ("0-3,6") each connection's Paho callback thread (on its first
+    // message) and then its workers are pinned round robin to the listed CPUs. Paho C may run
+    // the callbacks of all connections on one thread; it then stays on the first CPU it got.
+    size_t mqtt_connections = 1;                           // MQTT_CONNECTIONS
+    std::string cpu_affinity;                              // CPU_AFFINITY, empty = not pinned
+
+    long metrics_port = 9102;                              // METRICS_PORT, Prometheus /metrics, 0 = off
+    std::string metrics_bind = "127.0.0.1";                // METRICS_BIND, IPv4 address; 0.0.0.0 exposes it
+
+    std::string subscriptions_file;                        // SUBSCRIPTIONS_FILE, empty = built-in TLab topics
+    std::string deadband_file;                             // DEADBAND_FILE, empty = every metric forwarded
+
+    std::string fastapi_url = "http://fastapi:8000";   // FASTAPI_URL
+    size_t http_pool_size = 4;                          // FASTAPI_POOL_SIZE
+    long http_timeout_ms = 5000;                        // FASTAPI_TIMEOUT_MS
+
+    size_t ingest_workers = 2;                          // INGEST_WORKERS
+    size_t ingest_queue_capacity = 8192;                // INGEST_QUEUE_CAPACITY (per worker)
+    std::string ingest_overflow = "block";              // INGEST_OVERFLOW: block | drop-oldest | drop-newest
+
+    // Comma separated list of sinks: fastapi, ilp_tcp, ilp_http, file (SINKS).
+    // Batching/retry per sink: <FASTAPI|ILP_TCP|ILP_HTTP|FILE>_BATCH_MAX_MESSAGES etc., see SinkPolicy.
+    std::string sinks = "fastapi";                      // SINKS
+    std::string file_sink_path = "logs/sink.jsonl";     // FILE_SINK_PATH
+    std::string questdb_ilp_tcp_conf = "tcp::addr=questdb:9009;protocol_version=2;";   // QUESTDB_ILP_TCP_CONF
+    std::string questdb_ilp_http_conf = "http::addr=questdb:9000;";                     // QUESTDB_ILP_HTTP_CONF
+
+    static SubscriberConfig from_env();
+
+    // Why these settings cannot run, empty when they can
+    std::string startup_error() const;
+
+    bool owns_node(const SparkplugTopic& topic) const;
+};
+
+// Small helpers so every module reads its env variables the same way
+std::string env_string(const char* name, const std::string& fallback);
+long env_long(const char* name, long fallback);
@@ -0,0 +1,84 @@
+#include "subscriptions.h"
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+using json = nlohmann::json;
+
+std::vector<Subscription> default_subscriptions() {
+    // Births and deaths go to every instance so each keeps the full node state
+    return {
+        {"spBv1.0/UCL-SEE-A/NBIRTH/TLab", MessageType::NBIRTH, false},
+        {"spBv1.0/UCL-SEE-A/NDEATH/TLab", MessageType::NDEATH, false},
+        {"spBv1.0/UCL-SEE-A/DDATA/TLab/VentSensor1", MessageType::DDATA, true},
+        {"spBv1.0/+/NDATA/+", MessageType::NDATA, true},
+        {"spBv1.0/+/NCMD/+", MessageType::NCMD, true},
+        {"spBv1.0/+/DCMD/+/+", MessageType::DCMD, true},
+    };
+}
+
+std::vector<Subscription> load_subscriptions(const std::string& path) {
+    if (path.empty()) {
+        return default_subscriptions();
+    }
+    std::ifstream in(path);
+    if (!in) {
+        spdlog::error("Cannot open subscriptions file {}, using the built-in subscriptions", path);
+        return default_subscriptions();
+    }
+
+    json doc = json::parse(in, nullptr, false);
+    if (doc.is_discarded() || !doc.contains("subscriptions") || !doc["subscriptions"].is_array()) {
+        spdlog::error("Subscriptions file {} has no \"subscriptions\" array, using the built-in subscriptions", path);
+        return default_subscriptions();
+    }
+
+    std::vector<Subscription> subscriptions;
+    TopicRouter<size_t> check;
+    for (const auto& entry : doc["subscriptions"]) {
+        Subscription sub;
+        sub.filter = entry.value("filter", "");
+        std::string handler = entry.value("handler", "");
+        sub.handler = message_type_from(handler);
+        sub.shared = entry.value("shared", true);
+        if (sub.handler == MessageType::Unknown) {
+            spdlog::error("Subscription {}: unknown handler '{}', skipped", sub.filter, handler);
+            continue;
+        }
+        if (sub.filter.empty() || !check.add(sub.filter, subscriptions.size())) {
+            spdlog::error("Subscription '{}': invalid topic filter, skipped", sub.filter);
+            continue;
+        }
+        subscriptions.push_back(std::move(sub));
+    }
+    if (subscriptions.empty()) {
+        spdlog::error("Subscriptions file {} has no valid entries, using the built-in subscriptions", path);
+        return default_subscriptions();
+    }
+    return subscriptions;
+}
+
+MessageType handled_type(const SparkplugTopic& topic, MessageType handler) {
+    if (topic.valid()) {
+        return topic.type;
+    }
+    if (topic.group_id.empty() || topic.node_id.empty() || handler == MessageType::STATE) {
+        return MessageType::Unknown;
+    }
+    // A Sparkplug type in the wrong shape (e.g. NBIRTH with a device id) is malformed, not custom
+    const char* level = topic.group_id.data() + topic.group_id.size() + 1;
+    if (message_type_from(std::string_view(level, topic.node_id.data() - 1 - level)) != MessageType::Unknown) {
+        return MessageType::Unknown;
+    }
+    bool device_type = handler == MessageType::DBIRTH || handler == MessageType::DDEATH ||
+                       handler == MessageType::DDATA || handler == MessageType::DCMD;
+    return device_type == topic.is_device() ? handler : MessageType::Unknown;
+}
+
+TopicRouter<size_t> build_topic_router(const std::vector<Subscription>& subscriptions) {
+    TopicRouter<size_t> router;
+    for (size_t i = 0; i < subscriptions.size(); ++i) {
+        router.add(subscriptions[i].filter, i);
+    }
+    return router;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "sparkplugTopic.h"
+#include "topicRouter.h"
+
+/**
+ * One topic filter paho-sub subscribes to and the handler its messages go to.
+ * Handlers are named after the Sparkplug message type they process (NBIRTH, DDATA, ...).
+ */
+struct Subscription {
+    std::string filter;                    // MQTT filter, + and # allowed
+    MessageType handler = MessageType::Unknown;
+    bool shared = true;                    // Through $share/<group>/ when a share group is set
+};
+
+/**
+ * Subscriptions from a JSON file (SUBSCRIPTIONS_FILE):
+ *   {"subscriptions": [{"filter": "spBv1.0/+/DDATA/+/+", "handler": "DDATA", "shared": true}, ...]}
+ * Invalid entries are logged and skipped. Without a file, or when it cannot be read,
+ * the built-in TLab subscriptions are used.
+ */
+std::vector<Subscription> load_subscriptions(const std::string& path);
+std::vector<Subscription> default_subscriptions();
+
+// Handler index per filter, in file order, so the first listed filter wins on overlaps
+TopicRouter<size_t> build_topic_router(const std::vector<Subscription>& subscriptions);
+
+/**
+ * Type a message is processed as. The type parsed from the topic always wins, so a wildcard
+ * filter never turns a birth, death or STATE into its handler's type. The handler only names
+ * topics the parser left Unknown for a non-Sparkplug type level, when they still have a group,
+ * a node and the handler's shape (a device id exactly for the device level types).
+ */
+MessageType handled_type(const SparkplugTopic& topic, MessageType handler);
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include "ackGate.h"
+
+using namespace std::chrono_literals;
+
+TEST(AckGateTest, TicketReleasedWithItsLastCopy) {
+    AckGate gate(4, 100ms);
+    AckGate::Ticket ticket = gate.acquire();
+    AckGate::Ticket copy = ticket;
+    EXPECT_EQ(gate.outstanding(), 1u);
+
+    ticket.reset();
+    EXPECT_EQ(gate.outstanding(), 1u);
+    copy.reset();
+    EXPECT_EQ(gate.outstanding(), 0u);
+    EXPECT_EQ(gate.stats().acquired.load(), 1u);
+    EXPECT_EQ(gate.stats().released.load(), 1u);
+}
+
+TEST(AckGateTest, NoWaitWhileWindowHasRoom) {
+    AckGate gate(2, 1000ms);
+    AckGate::Ticket a = gate.acquire();
+    AckGate::Ticket b = gate.acquire();
+    gate.wait_for_window();
+    EXPECT_EQ(gate.stats().waits.load(), 0u);
+    EXPECT_EQ(gate.stats().high_watermark.load(), 2u);
+}
+
+TEST(AckGateTest, WaitEndsWhenTicketIsReleased) {
+    AckGate gate(0, 5000ms);
+    AckGate::Ticket ticket = gate.acquire();
+    std::thread sink([&ticket] {
+        std::this_thread::sleep_for(20ms);
+        ticket.reset();
+    });
+
+    auto started = std::chrono::steady_clock::now();
+    gate.wait_for_window();
+    auto waited = std::chrono::steady_clock::now() - started;
+    sink.join();
+
+    EXPECT_LT(waited, 2000ms);
+    EXPECT_EQ(gate.stats().timeouts.load(), 0u);
+    EXPECT_EQ(gate.outstanding(), 0u);
+}
+
+// A sink that never lets go must not wedge the callback thread
+TEST(AckGateTest, WaitIsBoundedByMaxWait) {
+    AckGate gate(0, 30ms);
+    AckGate::Ticket stuck = gate.acquire();
+
+    auto started = std::chrono::steady_clock::now();
+    gate.wait_for_window();
+    auto waited = std::chrono::steady_clock::now() - started;
+
+    EXPECT_GE(waited, 30ms);
+    EXPECT_EQ(gate.stats().timeouts.load(), 1u);
+    EXPECT_EQ(gate.outstanding(), 1u);
+}
+
+TEST(AckGateTest, CloseLetsWaitersGo) {
+    AckGate gate(0, 5000ms);
+    AckGate::Ticket stuck = gate.acquire();
+    std::thread closer([&gate] {
+        std::this_thread::sleep_for(20ms);
+        gate.close();
+    });
+
+    auto started = std::chrono::steady_clock::now();
+    gate.wait_for_window();
+    auto waited = std::chrono::steady_clock::now() - started;
+    closer.join();
+
+    EXPECT_LT(waited, 2000ms);
+    EXPECT_EQ(gate.stats().timeouts.load(), 0u);
+}
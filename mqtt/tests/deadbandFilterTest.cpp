@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "deadbandFilter.h"
+#include "metrics.h"
+
+namespace {
+
+constexpr int64_t T0 = 1731600000000;
+
+DeadbandRule rule(const char* metric, double absolute, double percent = 0, int64_t max_silence_ms = 0) {
+    DeadbandRule r;
+    r.metric = metric;
+    r.absolute = absolute;
+    r.percent = percent;
+    r.max_silence_ms = max_silence_ms;
+    return r;
+}
+
+std::string metric(const char* name, double value) {
+    return "{\"name\":\"" + std::string(name) + "\",\"dataType\":\"Double\",\"value\":" + std::to_string(value) + "}";
+}
+
+std::string metric(const char* name, const char* value) {
+    return "{\"name\":\"" + std::string(name) + "\",\"dataType\":\"String\",\"value\":\"" + value + "\"}";
+}
+
+DecodedMessage::Ptr message(const char* type, int64_t timestamp_ms, const std::string& metrics) {
+    return DecodedMessage::decode("spBv1.0/UCL-SEE-A/" + std::string(type) + "/TLab/VentSensor1",
+        "{\"timestamp\":" + std::to_string(timestamp_ms) + ",\"seq\":1,\"metrics\":[" + metrics + "]}");
+}
+
+DecodedMessage::Ptr ddata(int64_t timestamp_ms, const std::string& metrics) {
+    return message("DDATA", timestamp_ms, metrics);
+}
+
+// Number of metrics forwarded, 0 when the whole message was dropped
+size_t forwarded(DeadbandFilter& filter, const DecodedMessage::Ptr& msg) {
+    DecodedMessage::Ptr out = filter.filter(msg);
+    return out ? out->metrics.size() : 0;
+}
+
+}  // namespace
+
+TEST(DeadbandFilterTest, AbsoluteBandAgainstLastForwardedValue) {
+    DeadbandOptions options;
+    options.rules.push_back(rule("Temperature", 0.5));
+    DeadbandFilter filter(std::move(options));
+
+    EXPECT_EQ(forwarded(filter, ddata(T0, metric("Temperature", 20.0))), 1u);
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 1000, metric("Temperature", 20.3))), 0u);
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 2000, metric("Temperature", 20.6))), 1u);
+    // Compared with 20.6, not with the suppressed 20.3
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 3000, metric("Temperature", 20.9))), 0u);
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 4000, metric("Temperature", 20.0))), 1u);
+}
+
+TEST(DeadbandFilterTest, PercentBand) {
+    DeadbandOptions options;
+    options.rules.push_back(rule("CO2", 0, 2));
+    DeadbandFilter filter(std::move(options));
+
+    EXPECT_EQ(forwarded(filter, ddata(T0, metric("CO2", 100.0))), 1u);
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 1000, metric("CO2", 101.5))), 0u);
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 2000, metric("CO2", 97.5))), 1u);
+}
+
+TEST(DeadbandFilterTest, MessageKeepsOnlyPassingMetrics) {
+    DeadbandOptions options;
+    options.has_default = true;
+    options.default_rule = rule("*", 1.0);
+    DeadbandFilter filter(std::move(options));
+
+    filter.filter(ddata(T0, metric("A", 1.0) + "," + metric("B", 1.0)));
+    DecodedMessage::Ptr out = filter.filter(ddata(T0 + 1000, metric("A", 1.5) + "," + metric("B", 5.0)));
+    ASSERT_NE(out, nullptr);
+    ASSERT_EQ(out->metrics.size(), 1u);
+    EXPECT_EQ(out->metrics[0].name, "B");
+}
+
+TEST(DeadbandFilterTest, MaxSilenceForwardsUnchangedValue) {
+    DeadbandOptions options;
+    options.rules.push_back(rule("Temperature", 0.5, 0, 300000));
+    DeadbandFilter filter(std::move(options));
+    auto& heartbeats = pipeline_metrics().deadband.heartbeats;
+    uint64_t before = heartbeats.load();
+
+    EXPECT_EQ(forwarded(filter, ddata(T0, metric("Temperature", 20.0))), 1u);
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 299999, metric("Temperature", 20.0))), 0u);
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 300000, metric("Temperature", 20.0))), 1u);
+    EXPECT_EQ(heartbeats.load(), before + 1);
+    // The silence is counted again from the heartbeat
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 400000, metric("Temperature", 20.0))), 0u);
+}
+
+TEST(DeadbandFilterTest, BirthPassesAndSeedsLastValue) {
+    DeadbandOptions options;
+    options.rules.push_back(rule("Temperature", 0.5));
+    DeadbandFilter filter(std::move(options));
+
+    DecodedMessage::Ptr birth = message("DBIRTH", T0, metric("Temperature", 20.0));
+    EXPECT_EQ(filter.filter(birth), birth);
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 1000, metric("Temperature", 20.2))), 0u);
+
+    // A rebirth passes even without a change and resets the reference
+    EXPECT_EQ(forwarded(filter, message("DBIRTH", T0 + 2000, metric("Temperature", 25.0))), 1u);
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 3000, metric("Temperature", 20.2))), 1u);
+}
+
+TEST(DeadbandFilterTest, PrefixRuleAndUnmatchedMetrics) {
+    DeadbandOptions options;
+    options.rules.push_back(rule("Node Control/*", 0));
+    DeadbandFilter filter(std::move(options));
+
+    // absolute 0: any change passes, a repeat does not
+    EXPECT_EQ(forwarded(filter, ddata(T0, metric("Node Control/Rebirth", 0.0))), 1u);
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 1000, metric("Node Control/Rebirth", 0.0))), 0u);
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 2000, metric("Node Control/Rebirth", 1.0))), 1u);
+
+    // No rule and no default: never filtered
+    EXPECT_EQ(forwarded(filter, ddata(T0, metric("Humidity", 50.0))), 1u);
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 1000, metric("Humidity", 50.0))), 1u);
+}
+
+TEST(DeadbandFilterTest, StringsForwardedOnChange) {
+    DeadbandOptions options;
+    options.has_default = true;
+    options.default_rule = rule("*", 0.5);
+    DeadbandFilter filter(std::move(options));
+
+    EXPECT_EQ(forwarded(filter, ddata(T0, metric("Mode", "auto"))), 1u);
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 1000, metric("Mode", "auto"))), 0u);
+    EXPECT_EQ(forwarded(filter, ddata(T0 + 2000, metric("Mode", "manual"))), 1u);
+}
+
+TEST(DeadbandFilterTest, DisabledFilterReturnsMessageItself) {
+    DeadbandFilter filter{DeadbandOptions()};
+    EXPECT_FALSE(filter.enabled());
+    DecodedMessage::Ptr msg = ddata(T0, metric("Temperature", 20.0));
+    EXPECT_EQ(filter.filter(msg), msg);
+    EXPECT_EQ(filter.filter(msg), msg);
+}
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "metricAliasTable.h"
+#include "metrics.h"
+
+namespace {
+
+const SparkplugTopic NBIRTH = parse_sparkplug_topic("spBv1.0/UCL-SEE-A/NBIRTH/TLab");
+const SparkplugTopic NDATA = parse_sparkplug_topic("spBv1.0/UCL-SEE-A/NDATA/TLab");
+const SparkplugTopic DBIRTH = parse_sparkplug_topic("spBv1.0/UCL-SEE-A/DBIRTH/TLab/VentSensor1");
+const SparkplugTopic DDATA = parse_sparkplug_topic("spBv1.0/UCL-SEE-A/DDATA/TLab/VentSensor1");
+
+DecodedMetric named(std::string_view name, int64_t alias = -1) {
+    DecodedMetric m;
+    m.name = name;
+    m.data_type = "Float";
+    m.has_alias = alias >= 0;
+    m.alias = alias >= 0 ? (uint64_t)alias : 0;
+    m.value = 1.0;
+    return m;
+}
+
+DecodedMetric by_alias(uint64_t alias) {
+    DecodedMetric m;
+    m.has_alias = true;
+    m.alias = alias;
+    m.value = 1.0;
+    return m;
+}
+
+// Resolve one metric, keeping the table's names alive for the test
+DecodedMetric resolve_one(MetricAliasTable& table, const SparkplugTopic& topic, DecodedMetric metric,
+                          std::vector<std::shared_ptr<const void>>& owners) {
+    std::vector<DecodedMetric> metrics{metric};
+    bool filled = false;
+    owners.push_back(table.resolve(topic, metrics, filled));
+    return metrics[0];
+}
+
+}  // namespace
+
+TEST(MetricAliasTableTest, AliasOnlyDataGetsNameFromBirth) {
+    MetricAliasTable table;
+    std::vector<DecodedMetric> birth{named("Temperature", 1), named("Humidity", 2)};
+    bool filled = true;
+    auto owner = table.resolve(NBIRTH, birth, filled);
+    EXPECT_FALSE(filled);
+    EXPECT_NE(birth[0].index, birth[1].index);
+
+    std::vector<DecodedMetric> data{by_alias(2)};
+    owner = table.resolve(NDATA, data, filled);
+    EXPECT_TRUE(filled);
+    EXPECT_EQ(data[0].name, "Humidity");
+    EXPECT_EQ(data[0].data_type, "Float");
+    EXPECT_EQ(data[0].index, birth[1].index);
+}
+
+// Slots follow the names, aliases are whatever the latest NBIRTH says
+TEST(MetricAliasTableTest, NbirthRebindsAliases) {
+    MetricAliasTable table;
+    std::vector<std::shared_ptr<const void>> owners;
+    std::vector<DecodedMetric> first{named("Temperature", 1), named("Humidity", 2), named("CO2", 3)};
+    bool filled;
+    owners.push_back(table.resolve(NBIRTH, first, filled));
+
+    std::vector<DecodedMetric> second{named("Temperature", 2), named("Humidity", 1)};
+    owners.push_back(table.resolve(NBIRTH, second, filled));
+    EXPECT_EQ(second[0].index, first[0].index);
+    EXPECT_EQ(second[1].index, first[1].index);
+
+    EXPECT_EQ(resolve_one(table, NDATA, by_alias(1), owners).name, "Humidity");
+    EXPECT_EQ(resolve_one(table, NDATA, by_alias(2), owners).name, "Temperature");
+
+    // Alias 3 was not in the new birth: no longer bound
+    auto& unresolved = pipeline_metrics().aliases.unresolved;
+    uint64_t before = unresolved.load();
+    DecodedMetric stale = resolve_one(table, NDATA, by_alias(3), owners);
+    EXPECT_TRUE(stale.name.empty());
+    EXPECT_FALSE(stale.has_index());
+    EXPECT_EQ(unresolved.load(), before + 1);
+}
+
+TEST(MetricAliasTableTest, SparseAliasesBeyondDenseRange) {
+    MetricAliasTable table;
+    std::vector<std::shared_ptr<const void>> owners;
+    const uint64_t huge = 1ULL << 40;
+    std::vector<DecodedMetric> birth{named("A", 5), named("B", huge), named("C", 70000), named("D", huge + 1)};
+    bool filled;
+    owners.push_back(table.resolve(NBIRTH, birth, filled));
+
+    EXPECT_EQ(resolve_one(table, NDATA, by_alias(5), owners).name, "A");
+    EXPECT_EQ(resolve_one(table, NDATA, by_alias(huge), owners).name, "B");
+    EXPECT_EQ(resolve_one(table, NDATA, by_alias(70000), owners).name, "C");
+    EXPECT_EQ(resolve_one(table, NDATA, by_alias(huge + 1), owners).name, "D");
+    EXPECT_FALSE(resolve_one(table, NDATA, by_alias(70001), owners).has_index());
+    EXPECT_FALSE(resolve_one(table, NDATA, by_alias(huge - 1), owners).has_index());
+
+    // Sparse bindings are dropped by an NBIRTH like dense ones
+    std::vector<DecodedMetric> rebirth{named("A", 5)};
+    owners.push_back(table.resolve(NBIRTH, rebirth, filled));
+    EXPECT_FALSE(resolve_one(table, NDATA, by_alias(huge), owners).has_index());
+    EXPECT_EQ(resolve_one(table, NDATA, by_alias(5), owners).name, "A");
+}
+
+TEST(MetricAliasTableTest, DeviceMetricsHaveTheirOwnSlots) {
+    MetricAliasTable table;
+    std::vector<std::shared_ptr<const void>> owners;
+    std::vector<DecodedMetric> node_birth{named("Temperature", 1)};
+    bool filled;
+    owners.push_back(table.resolve(NBIRTH, node_birth, filled));
+    std::vector<DecodedMetric> device_birth{named("Temperature", 10)};
+    owners.push_back(table.resolve(DBIRTH, device_birth, filled));
+    EXPECT_NE(device_birth[0].index, node_birth[0].index);
+
+    // A DBIRTH adds bindings without dropping the node's
+    EXPECT_EQ(resolve_one(table, NDATA, by_alias(1), owners).index, node_birth[0].index);
+    EXPECT_EQ(resolve_one(table, DDATA, by_alias(10), owners).index, device_birth[0].index);
+    EXPECT_EQ(table.nodes(), 1u);
+}
+
+TEST(MetricAliasTableTest, NamedMetricsWithoutBirthGetStableSlots) {
+    MetricAliasTable table;
+    std::vector<std::shared_ptr<const void>> owners;
+    DecodedMetric first = resolve_one(table, DDATA, named("Pressure"), owners);
+    DecodedMetric again = resolve_one(table, DDATA, named("Pressure"), owners);
+    DecodedMetric other = resolve_one(table, DDATA, named("Flow"), owners);
+    EXPECT_TRUE(first.has_index());
+    EXPECT_EQ(again.index, first.index);
+    EXPECT_NE(other.index, first.index);
+
+    // Alias only metrics of a birth never seen stay unresolved
+    EXPECT_FALSE(resolve_one(table, DDATA, by_alias(4), owners).has_index());
+}
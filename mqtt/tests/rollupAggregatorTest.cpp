@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "metrics.h"
+#include "rollupAggregator.h"
+
+namespace {
+
+// On a whole hour, so 1 s, 1 min and 1 h buckets all start here
+constexpr int64_t T0 = 1731600000000;
+// Before 1970 and on a whole second; at least 1e11 in magnitude, so decode() reads it as ms
+constexpr int64_t NEG = -200000000000;
+
+void sample(RollupAggregator& rollups, int64_t timestamp_ms, double value) {
+    auto msg = DecodedMessage::decode("spBv1.0/UCL-SEE-A/DDATA/TLab/VentSensor1",
+        "{\"timestamp\":" + std::to_string(timestamp_ms) + ",\"seq\":1,\"metrics\":[{\"name\":\"Temperature\","
+        "\"dataType\":\"Double\",\"timestamp\":" + std::to_string(timestamp_ms) + ",\"value\":" +
+        std::to_string(value) + "}]}");
+    rollups.observe(*msg);
+}
+
+std::vector<RollupRow> rows_of(const std::vector<RollupRow>& rows, RollupResolution resolution) {
+    std::vector<RollupRow> out;
+    for (const RollupRow& row : rows) {
+        if (row.resolution == resolution) {
+            out.push_back(row);
+        }
+    }
+    return out;
+}
+
+RollupOptions options() {
+    RollupOptions o;
+    o.enabled = true;
+    o.grace = std::chrono::hours(1);    // Nothing is closed for silence while a test runs
+    return o;
+}
+
+}  // namespace
+
+TEST(RollupAggregatorTest, BucketClosesWhenNextOneStarts) {
+    RollupAggregator rollups(options());
+    sample(rollups, T0 + 100, 1.0);
+    sample(rollups, T0 + 999, 3.0);
+    std::vector<RollupRow> rows;
+    rollups.collect(rows);
+    EXPECT_TRUE(rows.empty());
+
+    sample(rollups, T0 + 1000, 2.0);
+    rollups.collect(rows);
+    ASSERT_EQ(rows.size(), 1u);
+    const RollupRow& row = rows[0];
+    EXPECT_EQ(row.resolution, RollupResolution::Second);
+    EXPECT_EQ(row.bucket_start_ms, T0);
+    EXPECT_EQ(row.group_id, "UCL-SEE-A");
+    EXPECT_EQ(row.device_id, "VentSensor1");
+    EXPECT_EQ(row.metric, "Temperature");
+    EXPECT_EQ(row.count, 2u);
+    EXPECT_DOUBLE_EQ(row.min, 1.0);
+    EXPECT_DOUBLE_EQ(row.max, 3.0);
+    EXPECT_DOUBLE_EQ(row.avg, 2.0);
+    EXPECT_DOUBLE_EQ(row.last, 3.0);
+}
+
+TEST(RollupAggregatorTest, CollectAllClosesEveryResolution) {
+    RollupAggregator rollups(options());
+    sample(rollups, T0 + 59999, 1.0);
+    sample(rollups, T0 + 60000, 2.0);
+    sample(rollups, T0 + 3599999, 3.0);
+    sample(rollups, T0 + 3600000, 4.0);
+    std::vector<RollupRow> rows;
+    rollups.collect(rows, true);
+
+    EXPECT_EQ(rows_of(rows, RollupResolution::Second).size(), 4u);
+    std::vector<RollupRow> minutes = rows_of(rows, RollupResolution::Minute);
+    ASSERT_EQ(minutes.size(), 4u);
+    EXPECT_EQ(minutes[0].bucket_start_ms, T0);
+    EXPECT_EQ(minutes[1].bucket_start_ms, T0 + 60000);
+    EXPECT_EQ(minutes[2].bucket_start_ms, T0 + 3540000);
+    EXPECT_EQ(minutes[3].bucket_start_ms, T0 + 3600000);
+    std::vector<RollupRow> hours = rows_of(rows, RollupResolution::Hour);
+    ASSERT_EQ(hours.size(), 2u);
+    EXPECT_EQ(hours[0].bucket_start_ms, T0);
+    EXPECT_EQ(hours[0].count, 3u);
+    EXPECT_DOUBLE_EQ(hours[0].avg, 2.0);
+    EXPECT_EQ(hours[1].bucket_start_ms, T0 + 3600000);
+    EXPECT_EQ(rollups.series(), 1u);
+}
+
+// Buckets of pre-1970 timestamps start at or before them, not after (no truncation toward zero)
+TEST(RollupAggregatorTest, NegativeTimestampsFloorDown) {
+    RollupAggregator rollups(options());
+    sample(rollups, NEG - 1, 1.0);
+    sample(rollups, NEG - 1000, 2.0);
+    sample(rollups, NEG, 3.0);
+    std::vector<RollupRow> rows;
+    rollups.collect(rows, true);
+
+    std::vector<RollupRow> seconds = rows_of(rows, RollupResolution::Second);
+    ASSERT_EQ(seconds.size(), 2u);
+    EXPECT_EQ(seconds[0].bucket_start_ms, NEG - 1000);
+    EXPECT_EQ(seconds[0].count, 2u);
+    EXPECT_DOUBLE_EQ(seconds[0].last, 1.0);
+    EXPECT_EQ(seconds[1].bucket_start_ms, NEG);
+    EXPECT_EQ(seconds[1].count, 1u);
+    // NEG is not on a minute or hour boundary: one wider bucket around all three samples
+    for (RollupResolution resolution : {RollupResolution::Minute, RollupResolution::Hour}) {
+        std::vector<RollupRow> wider = rows_of(rows, resolution);
+        ASSERT_EQ(wider.size(), 1u);
+        EXPECT_EQ(wider[0].count, 3u);
+        EXPECT_LE(wider[0].bucket_start_ms, NEG - 1000);
+        EXPECT_GT(wider[0].bucket_start_ms + rollup_width_ms(resolution), NEG);
+        EXPECT_EQ(wider[0].bucket_start_ms % rollup_width_ms(resolution), 0);
+    }
+}
+
+TEST(RollupAggregatorTest, LateSampleLeftOutOfClosedBucket) {
+    RollupAggregator rollups(options());
+    auto& late = pipeline_metrics().rollup.late;
+    uint64_t before = late.load();
+
+    sample(rollups, T0 + 1500, 1.0);
+    sample(rollups, T0 + 2100, 2.0);       // Closes the 1 s bucket at T0 + 1000
+    sample(rollups, T0 + 1200, 10.0);      // Belongs to it, too late
+    sample(rollups, T0 + 500, 20.0);       // Older than every 1 s bucket seen
+    EXPECT_EQ(late.load(), before + 2);
+
+    std::vector<RollupRow> rows;
+    rollups.collect(rows, true);
+    std::vector<RollupRow> seconds = rows_of(rows, RollupResolution::Second);
+    ASSERT_EQ(seconds.size(), 2u);
+    EXPECT_EQ(seconds[0].bucket_start_ms, T0 + 1000);
+    EXPECT_EQ(seconds[0].count, 1u);
+    EXPECT_EQ(seconds[1].bucket_start_ms, T0 + 2000);
+    EXPECT_EQ(seconds[1].count, 1u);
+
+    // Still open at the wider resolutions, so counted there
+    std::vector<RollupRow> minutes = rows_of(rows, RollupResolution::Minute);
+    ASSERT_EQ(minutes.size(), 1u);
+    EXPECT_EQ(minutes[0].count, 4u);
+    EXPECT_DOUBLE_EQ(minutes[0].max, 20.0);
+    EXPECT_DOUBLE_EQ(minutes[0].last, 2.0);    // Latest by timestamp, not by arrival
+}
+
+TEST(RollupAggregatorTest, OutOfOrderWithinBucketKeepsLatestAsLast) {
+    RollupAggregator rollups(options());
+    sample(rollups, T0 + 600, 5.0);
+    sample(rollups, T0 + 300, 7.0);
+    std::vector<RollupRow> rows;
+    rollups.collect(rows, true);
+    std::vector<RollupRow> seconds = rows_of(rows, RollupResolution::Second);
+    ASSERT_EQ(seconds.size(), 1u);
+    EXPECT_EQ(seconds[0].count, 2u);
+    EXPECT_DOUBLE_EQ(seconds[0].last, 5.0);
+    EXPECT_DOUBLE_EQ(seconds[0].max, 7.0);
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "metrics.h"
+#include "sequenceTracker.h"
+
+namespace {
+
+std::string topic(const char* type) {
+    return "spBv1.0/UCL-SEE-A/" + std::string(type) + "/TLab";
+}
+
+DecodedMessage::Ptr nbirth(int64_t bd_seq, int64_t timestamp_ms, double temperature = 21.5) {
+    return DecodedMessage::decode(topic("NBIRTH"),
+        "{\"timestamp\":" + std::to_string(timestamp_ms) + ",\"seq\":0,\"metrics\":[{\"name\":\"bdSeq\","
+        "\"dataType\":\"UInt64\",\"value\":" + std::to_string(bd_seq) + "},{\"name\":\"Temperature\","
+        "\"dataType\":\"Float\",\"value\":" + std::to_string(temperature) + "}]}");
+}
+
+DecodedMessage::Ptr ndeath(int64_t bd_seq) {
+    std::string metrics = bd_seq < 0 ? "" : "{\"name\":\"bdSeq\",\"dataType\":\"UInt64\",\"value\":" +
+                                                std::to_string(bd_seq) + "}";
+    return DecodedMessage::decode(topic("NDEATH"), "{\"timestamp\":1731600009000,\"metrics\":[" + metrics + "]}");
+}
+
+DecodedMessage::Ptr ndata(int64_t seq) {
+    return DecodedMessage::decode(topic("NDATA"),
+        "{\"timestamp\":1731600005000,\"seq\":" + std::to_string(seq) + ",\"metrics\":[{\"name\":\"Temperature\","
+        "\"dataType\":\"Float\",\"value\":21.5}]}");
+}
+
+}  // namespace
+
+TEST(SequenceTrackerTest, InOrderDuplicateAndGap) {
+    SequenceTracker tracker;
+    EXPECT_EQ(tracker.check(*nbirth(0, 1731600000000)), SeqVerdict::InOrder);
+    EXPECT_EQ(tracker.check(*ndata(1)), SeqVerdict::InOrder);
+    EXPECT_EQ(tracker.check(*ndata(1)), SeqVerdict::Duplicate);
+    EXPECT_EQ(tracker.check(*ndata(3)), SeqVerdict::Gap);
+    EXPECT_EQ(tracker.check(*ndata(2)), SeqVerdict::Late);
+}
+
+TEST(SequenceTrackerTest, MatchingNdeathEndsSession) {
+    SequenceTracker tracker;
+    tracker.check(*nbirth(4, 1731600000000));
+    EXPECT_EQ(tracker.check(*ndeath(4)), SeqVerdict::InOrder);
+    EXPECT_EQ(tracker.check(*ndata(1)), SeqVerdict::NoBirth);
+}
+
+TEST(SequenceTrackerTest, NdeathWithoutBdSeqEndsSession) {
+    SequenceTracker tracker;
+    tracker.check(*nbirth(4, 1731600000000));
+    EXPECT_EQ(tracker.check(*ndeath(-1)), SeqVerdict::InOrder);
+    EXPECT_EQ(tracker.check(*ndata(1)), SeqVerdict::NoBirth);
+}
+
+// A node restarting within the same second may reuse its bdSeq: only an identical NBIRTH is a redelivery
+TEST(SequenceTrackerTest, RestartWithinSameSecondIsRebirth) {
+    SequenceTracker tracker;
+    EXPECT_EQ(tracker.check(*nbirth(3, 1731600000000)), SeqVerdict::InOrder);
+    EXPECT_EQ(tracker.check(*ndata(1)), SeqVerdict::InOrder);
+    EXPECT_EQ(tracker.check(*ndata(2)), SeqVerdict::InOrder);
+    EXPECT_EQ(tracker.check(*nbirth(3, 1731600000000)), SeqVerdict::Duplicate);
+
+    EXPECT_EQ(tracker.check(*nbirth(3, 1731600000000, 22.0)), SeqVerdict::InOrder);
+    EXPECT_EQ(tracker.check(*ndata(1)), SeqVerdict::InOrder);
+}
+
+// The will of the old session is delivered after the node already came back with a new bdSeq
+TEST(SequenceTrackerTest, StaleNdeathAfterRebirthKeepsNodeAlive) {
+    SequenceTracker tracker;
+    auto& mismatches = pipeline_metrics().sequence.bd_seq_mismatch;
+    uint64_t before = mismatches.load();
+
+    EXPECT_EQ(tracker.check(*nbirth(0, 1731600000000)), SeqVerdict::InOrder);
+    EXPECT_EQ(tracker.check(*nbirth(1, 1731600001000)), SeqVerdict::InOrder);
+    EXPECT_EQ(tracker.check(*ndeath(0)), SeqVerdict::InOrder);
+    EXPECT_EQ(mismatches.load(), before + 1);
+
+    EXPECT_EQ(tracker.check(*ndata(1)), SeqVerdict::InOrder);
+    EXPECT_EQ(tracker.check(*ndeath(1)), SeqVerdict::InOrder);
+    EXPECT_EQ(tracker.check(*ndata(2)), SeqVerdict::NoBirth);
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "subscriptions.h"
+#include "topicRouter.h"
+
+namespace {
+
+int route(const TopicRouter<int>& router, const char* topic) {
+    const int* value = router.match(topic);
+    return value ? *value : -1;
+}
+
+MessageType handled(const char* topic, MessageType handler) {
+    return handled_type(parse_sparkplug_topic(topic), handler);
+}
+
+}  // namespace
+
+TEST(TopicRouterTest, ExactPlusAndHash) {
+    TopicRouter<int> router;
+    ASSERT_TRUE(router.add("spBv1.0/G/NBIRTH/N", 1));
+    ASSERT_TRUE(router.add("spBv1.0/+/DDATA/+/+", 2));
+    ASSERT_TRUE(router.add("spBv1.0/G/#", 3));
+    EXPECT_EQ(router.size(), 3u);
+
+    EXPECT_EQ(route(router, "spBv1.0/G/NBIRTH/N"), 1);
+    EXPECT_EQ(route(router, "spBv1.0/X/DDATA/N/D"), 2);
+    EXPECT_EQ(route(router, "spBv1.0/G/NDATA/N"), 3);
+    EXPECT_EQ(route(router, "spBv1.0/X/DDATA/N"), -1);       // + fills exactly one level
+    EXPECT_EQ(route(router, "spBv1.0/X/DDATA/N/D/E"), -1);
+    EXPECT_EQ(route(router, "spBv1.0/X/NDATA/N"), -1);
+}
+
+TEST(TopicRouterTest, HashAlsoMatchesItsParentLevel) {
+    TopicRouter<int> router;
+    router.add("spBv1.0/G/#", 1);
+    EXPECT_EQ(route(router, "spBv1.0/G"), 1);
+    EXPECT_EQ(route(router, "spBv1.0/G/a/b/c"), 1);
+    EXPECT_EQ(route(router, "spBv1.0/H"), -1);
+}
+
+TEST(TopicRouterTest, FirstAddedFilterWins) {
+    TopicRouter<int> router;
+    router.add("spBv1.0/#", 1);
+    router.add("spBv1.0/G/DDATA/N/D", 2);
+    router.add("spBv1.0/#", 3);                              // Same filter again keeps the first value
+    EXPECT_EQ(router.size(), 2u);
+    EXPECT_EQ(route(router, "spBv1.0/G/DDATA/N/D"), 1);
+
+    TopicRouter<int> reversed;
+    reversed.add("spBv1.0/G/DDATA/N/D", 2);
+    reversed.add("spBv1.0/#", 1);
+    EXPECT_EQ(route(reversed, "spBv1.0/G/DDATA/N/D"), 2);
+    EXPECT_EQ(route(reversed, "spBv1.0/G/NDATA/N"), 1);
+}
+
+TEST(TopicRouterTest, SystemTopicsSkipLeadingWildcards) {
+    TopicRouter<int> router;
+    router.add("#", 1);
+    router.add("+/broker/load", 2);
+    router.add("$SYS/#", 3);
+    EXPECT_EQ(route(router, "$SYS/broker/load"), 3);
+    EXPECT_EQ(route(router, "other/broker/load"), 1);
+}
+
+TEST(TopicRouterTest, InvalidFiltersAreRefused) {
+    TopicRouter<int> router;
+    EXPECT_FALSE(router.add("spBv1.0/#/DDATA", 1));
+    EXPECT_FALSE(router.add("spBv1.0/G+/DDATA", 1));
+    EXPECT_FALSE(router.add("spBv1.0/G/DDATA#", 1));
+    EXPECT_TRUE(router.empty());
+}
+
+// A wildcard subscription must not turn births, deaths or STATE into its handler's type
+TEST(TopicRouterTest, ParsedTypeWinsOverHandler) {
+    EXPECT_EQ(handled("spBv1.0/G/NBIRTH/N", MessageType::DDATA), MessageType::NBIRTH);
+    EXPECT_EQ(handled("spBv1.0/G/NDEATH/N", MessageType::DDATA), MessageType::NDEATH);
+    EXPECT_EQ(handled("spBv1.0/G/DBIRTH/N/D", MessageType::DDATA), MessageType::DBIRTH);
+    EXPECT_EQ(handled("spBv1.0/STATE/host", MessageType::DDATA), MessageType::STATE);
+    EXPECT_EQ(handled("spBv1.0/G/DDATA/N/D", MessageType::DDATA), MessageType::DDATA);
+}
+
+TEST(TopicRouterTest, HandlerOnlyNamesCustomTypeLevels) {
+    EXPECT_EQ(handled("spBv1.0/G/custom/N/D", MessageType::DDATA), MessageType::DDATA);
+    EXPECT_EQ(handled("spBv1.0/G/custom/N", MessageType::NDATA), MessageType::NDATA);
+    // Wrong shape for the handler, malformed Sparkplug, or not Sparkplug at all
+    EXPECT_EQ(handled("spBv1.0/G/custom/N", MessageType::DDATA), MessageType::Unknown);
+    EXPECT_EQ(handled("spBv1.0/G/NBIRTH/N/D", MessageType::DDATA), MessageType::Unknown);
+    EXPECT_EQ(handled("spBv1.0/G/custom/N", MessageType::STATE), MessageType::Unknown);
+    EXPECT_EQ(handled("plant/line1", MessageType::DDATA), MessageType::Unknown);
+}
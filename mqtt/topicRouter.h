@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <map>
+
+/**
+ * Compiled set of MQTT topic filters (with + and # wildcards) mapped to values.
+ * One trie node per filter level, so a match walks the topic levels once and only branches
+ * into the + and # children: the cost depends on the topic depth, not on the number of filters.
+ * When several filters match, the one added first wins.
+ */
+template <typename T>
+class TopicRouter {
+public:
+    // Filters follow the MQTT rules: # only as the last level, + and # fill a whole level
+    bool add(std::string_view filter, T value) {
+        Node* node = &root;
+        size_t start = 0;
+        for (;;) {
+            size_t slash = filter.find('/', start);
+            std::string_view level = filter.substr(start, slash == std::string_view::npos ? std::string_view::npos
+                                                                                         : slash - start);
+            if (level == "#") {
+                if (slash != std::string_view::npos) {
+                    return false;
+                }
+                set(node->hash_value, node->hash_order, std::move(value));
+                return true;
+            }
+            if (level != "+" && (level.find('+') != std::string_view::npos || level.find('#') != std::string_view::npos)) {
+                return false;
+            }
+            std::unique_ptr<Node>& child = level == "+" ? node->plus : node->children[std::string(level)];
+            if (!child) {
+                child = std::make_unique<Node>();
+            }
+            node = child.get();
+            if (slash == std::string_view::npos) {
+                break;
+            }
+            start = slash + 1;
+        }
+        set(node->value, node->order, std::move(value));
+        return true;
+    }
+
+    // The value of the first added filter matching the topic, nullptr when none does
+    const T* match(std::string_view topic) const {
+        const T* best = nullptr;
+        size_t best_order = NONE;
+        // Topics starting with $ (e.g. $SYS) never match filters starting with a wildcard
+        bool system = !topic.empty() && topic[0] == '$';
+        match(&root, topic, 0, system, best, best_order);
+        return best;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+
+    struct Node {
+        std::map<std::string, std::unique_ptr<Node>, std::less<>> children;   // Transparent: find by string_view
+        std::unique_ptr<Node> plus;
+        std::unique_ptr<T> value;            // Filter ends at this level
+        size_t order = NONE;
+        std::unique_ptr<T> hash_value;       // Filter ends with # below this level
+        size_t hash_order = NONE;
+    };
+
+    void set(std::unique_ptr<T>& slot, size_t& order, T value) {
+        if (slot) {
+            return;    // Same filter twice: the first one keeps priority
+        }
+        slot = std::make_unique<T>(std::move(value));
+        order = count++;
+    }
+
+    static void take(const std::unique_ptr<T>& value, size_t order, const T*& best, size_t& best_order) {
+        if (value && order < best_order) {
+            best = value.get();
+            best_order = order;
+        }
+    }
+
+    // `start` is the offset of the current level in topic
+    static void match(const Node* node, std::string_view topic, size_t start, bool system,
+                      const T*& best, size_t& best_order) {
+        // A # below this node matches whatever levels are left
+        if (!system) {
+            take(node->hash_value, node->hash_order, best, best_order);
+        }
+        size_t slash = topic.find('/', start);
+        std::string_view level = topic.substr(start, slash == std::string_view::npos ? std::string_view::npos
+                                                                                    : slash - start);
+        bool last = slash == std::string_view::npos;
+
+        auto it = node->children.find(level);
+        if (it != node->children.end()) {
+            descend(it->second.get(), topic, slash, last, best, best_order);
+        }
+        if (node->plus && !system) {
+            descend(node->plus.get(), topic, slash, last, best, best_order);
+        }
+    }
+
+    static void descend(const Node* child, std::string_view topic, size_t slash, bool last,
+                        const T*& best, size_t& best_order) {
+        if (last) {
+            // "a/#" also matches "a" itself
+            take(child->value, child->order, best, best_order);
+            take(child->hash_value, child->hash_order, best, best_order);
+        } else {
+            match(child, topic, slash + 1, false, best, best_order);
+        }
+    }
+
+    Node root;
+    size_t count = 0;
+};